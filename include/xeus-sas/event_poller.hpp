@@ -0,0 +1,91 @@
+#ifndef XEUS_SAS_EVENT_POLLER_HPP
+#define XEUS_SAS_EVENT_POLLER_HPP
+
+#include <vector>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Readiness notification for a single file descriptor
+     */
+    struct poll_event
+    {
+        int fd;           // Descriptor that became ready
+        bool readable;    // Data (or EOF) can be read without blocking
+        bool writable;    // Data can be written without blocking
+        bool hangup;      // Peer closed its end or an error is pending
+    };
+
+    /**
+     * @brief Event-driven readiness wait over a small set of descriptors
+     *
+     * Uses epoll on Linux and poll() elsewhere. Each poller owns a wakeup
+     * descriptor (eventfd on Linux, a self-pipe elsewhere) so that another
+     * thread - or a signal handler - can abort a blocking wait() at once
+     * instead of waiting for a timeout to expire.
+     */
+    class event_poller
+    {
+    public:
+        event_poller();
+        ~event_poller();
+
+        event_poller(const event_poller&) = delete;
+        event_poller& operator=(const event_poller&) = delete;
+
+        /**
+         * @brief Start watching a descriptor
+         * @param fd Descriptor to watch
+         * @param want_read Report readability
+         * @param want_write Report writability
+         */
+        void add(int fd, bool want_read, bool want_write = false);
+
+        /**
+         * @brief Change the interest set of a watched descriptor
+         */
+        void modify(int fd, bool want_read, bool want_write);
+
+        /**
+         * @brief Stop watching a descriptor (no-op if not watched)
+         */
+        void remove(int fd);
+
+        /**
+         * @brief Wait until a descriptor is ready, wake() is called, or timeout
+         *
+         * An interrupted system call (EINTR) returns early with no events so
+         * that callers re-evaluate their deadlines.
+         *
+         * @param events Output: ready descriptors (cleared first)
+         * @param timeout_ms Maximum wait in milliseconds (-1 = infinite)
+         * @return true if the wait was ended by wake()
+         */
+        bool wait(std::vector<poll_event>& events, int timeout_ms);
+
+        /**
+         * @brief Abort a concurrent or the next wait()
+         *
+         * Thread-safe and async-signal-safe (a single write()).
+         */
+        void wake();
+
+    private:
+        struct registration
+        {
+            int fd;
+            bool want_read;
+            bool want_write;
+        };
+
+        int m_epoll_fd;                             // -1 when poll() is used
+        int m_wake_read_fd;                         // eventfd or pipe read end
+        int m_wake_write_fd;                        // eventfd or pipe write end
+        std::vector<registration> m_registrations;  // Interest set (poll() backend)
+
+        void drain_wakeups();
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_EVENT_POLLER_HPP
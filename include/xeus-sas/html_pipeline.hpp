@@ -0,0 +1,106 @@
+#ifndef XEUS_SAS_HTML_PIPELINE_HPP
+#define XEUS_SAS_HTML_PIPELINE_HPP
+
+#include "xeus-sas/html_postprocess.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Cleans ODS output blocks on worker threads, hands them out in order
+     *
+     * The output reader push()es every top-level <div> block as soon as SAS
+     * has written it and goes back to draining the pipes; workers run
+     * clean_ods_html() on the blocks meanwhile. pop() returns cleaned blocks
+     * strictly in push order, so a slow block holds back the ones after it
+     * but never changes their order. Post-processing of one table thus
+     * overlaps with SAS computing the next.
+     *
+     * With zero workers, push() cleans the block on the calling thread.
+     */
+    class html_pipeline
+    {
+    public:
+        /**
+         * @brief Post-processing applied to a block
+         */
+        using cleaner = std::string (*)(const std::string&);
+
+        /**
+         * @brief Number of workers: XEUS_SAS_HTML_WORKERS, else 2 (0 = inline)
+         */
+        static size_t default_workers();
+
+        /**
+         * @brief Start the workers
+         * @param workers Worker threads (0 cleans inline in push())
+         * @param on_ready Called from a worker whenever a block is cleaned,
+         *                 e.g. to wake the thread that pop()s
+         */
+        explicit html_pipeline(size_t workers = default_workers(),
+                               std::function<void()> on_ready = std::function<void()>());
+
+        /**
+         * @brief Stops the workers; blocks not cleaned yet are dropped
+         */
+        ~html_pipeline();
+
+        html_pipeline(const html_pipeline&) = delete;
+        html_pipeline& operator=(const html_pipeline&) = delete;
+
+        /**
+         * @brief Queue a raw ODS block for cleaning
+         * @param block Markup of one output object
+         * @param clean clean_ods_html, or normalize_compact_html for output
+         *              of the xeus-sas tagset
+         */
+        void push(std::string block, cleaner clean = clean_ods_html);
+
+        /**
+         * @brief Take the oldest block if it has been cleaned
+         * @return false if it is still being cleaned or nothing is queued
+         */
+        bool pop(std::string& html);
+
+        /**
+         * @brief Take the oldest block, waiting until it has been cleaned
+         * @return false if nothing is queued
+         */
+        bool wait_pop(std::string& html);
+
+        /**
+         * @brief Whether blocks are queued that were not popped yet
+         */
+        bool pending() const;
+
+    private:
+        struct slot
+        {
+            std::string text;     // Raw block, replaced by the cleaned markup
+            cleaner clean;
+            bool ready;
+        };
+
+        void worker_loop();
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_work_available;
+        std::condition_variable m_block_ready;
+        std::deque<slot> m_slots;             // Oldest first; references stay valid
+        std::deque<slot*> m_jobs;             // Slots not picked up by a worker yet
+        std::function<void()> m_on_ready;
+        bool m_stopping;
+        std::vector<std::thread> m_workers;
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_HTML_PIPELINE_HPP
@@ -0,0 +1,42 @@
+#ifndef XEUS_SAS_HTML_POSTPROCESS_HPP
+#define XEUS_SAS_HTML_POSTPROCESS_HPP
+
+#include <string>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Simplify ODS HTML5 output for notebook and terminal renderers
+     *
+     * Renderers like euporie mis-align SAS tables, so this:
+     * - Merges split colgroups into one
+     * - Removes the "The SAS System" title container
+     * - Strips inline style and aria-label attributes
+     * - Moves thead rows to the top of tbody
+     * - Removes empty caption elements
+     * - Flattens rowspan/colspan (PROC TABULATE) into a plain grid
+     *
+     * Works on a whole document or on a single ODS output block. All but
+     * the flattening happen in one forward pass, so cost grows linearly
+     * with the size of the block.
+     *
+     * @param html Raw ODS HTML5 markup
+     * @return Simplified markup
+     */
+    std::string clean_ods_html(const std::string& html);
+
+    /**
+     * @brief Finish output of the xeus-sas ODS tagset (xeus_sas_tagset.sas)
+     *
+     * The tagset already writes what clean_ods_html() produces, except
+     * that spanning cells keep their rowspan/colspan. Tables are flattened
+     * only if a span occurs; otherwise the markup is returned unchanged.
+     *
+     * @param html Markup written by tagsets.xeus_sas
+     * @return Markup without spans
+     */
+    std::string normalize_compact_html(const std::string& html);
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_HTML_POSTPROCESS_HPP
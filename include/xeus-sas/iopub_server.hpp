@@ -0,0 +1,92 @@
+#ifndef XEUS_SAS_IOPUB_SERVER_HPP
+#define XEUS_SAS_IOPUB_SERVER_HPP
+
+#include <memory>
+#include <mutex>
+
+#include "xeus/xeus_context.hpp"
+#include "xeus/xkernel_configuration.hpp"
+#include "xeus/xmessage.hpp"
+#include "xeus/xserver.hpp"
+#include "nlohmann/json.hpp"
+
+namespace nl = nlohmann;
+
+namespace xeus_sas
+{
+    /**
+     * @brief Parent header for the iopub messages the calling thread publishes
+     *
+     * xeus stamps a published message with the header of the shell request
+     * it is handling at that moment. Cells reply asynchronously, so by the
+     * time a session worker publishes a cell's output xeus may be handling
+     * a later request. Within this scope, the messages of the calling
+     * thread carry @p parent instead (the cell's own header, captured when
+     * its request arrived). Scopes nest.
+     */
+    class publish_parent_scope
+    {
+    public:
+        /**
+         * @param parent Header of the request the output belongs to; must
+         *        outlive the scope
+         */
+        explicit publish_parent_scope(const nl::json& parent);
+        ~publish_parent_scope();
+
+        publish_parent_scope(const publish_parent_scope&) = delete;
+        publish_parent_scope& operator=(const publish_parent_scope&) = delete;
+
+        /**
+         * @brief Parent header of the innermost scope on this thread, or null
+         */
+        static const nl::json* current();
+
+    private:
+        const nl::json* m_previous;
+    };
+
+    /**
+     * @brief Kernel server that owns iopub publishing
+     *
+     * Wraps the server xeus-zmq builds and forwards everything to it. All
+     * iopub traffic (xeus's own status and execute_input messages from the
+     * shell thread as well as cell output from session workers) goes
+     * through publish_impl(), which sends one message at a time, since the
+     * underlying socket must not be used by two threads at once, and
+     * applies the publish_parent_scope of the publishing thread.
+     */
+    class iopub_server : public xeus::xserver
+    {
+    public:
+        explicit iopub_server(std::unique_ptr<xeus::xserver> server);
+        ~iopub_server() override = default;
+
+    private:
+        xeus::xcontrol_messenger& get_control_messenger_impl() override;
+
+        void send_shell_impl(xeus::xmessage message) override;
+        void send_control_impl(xeus::xmessage message) override;
+        void send_stdin_impl(xeus::xmessage message) override;
+        void publish_impl(xeus::xpub_message message, xeus::channel c) override;
+
+        void start_impl(xeus::xpub_message message) override;
+        void abort_queue_impl(const listener& l, long polling_interval) override;
+        void stop_impl() override;
+        void update_config_impl(xeus::xconfiguration& config) const override;
+
+        std::unique_ptr<xeus::xserver> m_server;
+        std::mutex m_publish_mutex;
+    };
+
+    /**
+     * @brief Server builder for xeus::xkernel: the default xeus-zmq server,
+     *        wrapped in an iopub_server
+     */
+    std::unique_ptr<xeus::xserver> make_iopub_server(xeus::xcontext& context,
+                                                     const xeus::xconfiguration& config,
+                                                     nl::json::error_handler_t eh);
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_IOPUB_SERVER_HPP
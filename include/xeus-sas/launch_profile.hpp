@@ -0,0 +1,134 @@
+#ifndef XEUS_SAS_LAUNCH_PROFILE_HPP
+#define XEUS_SAS_LAUNCH_PROFILE_HPP
+
+#include <string>
+#include <vector>
+
+namespace xeus_sas
+{
+    /**
+     * @brief SAS invocation options chosen for the host
+     *
+     * Empty values leave the SAS default (sasv9.cfg) in place. Values are
+     * passed to SAS as given, e.g. memsize "4G" becomes "-memsize 4G".
+     */
+    struct launch_profile
+    {
+        bool auto_tune = true;              // Fill unset values from cgroup limits
+        std::string memsize;                // -memsize
+        std::string sortsize;               // -sortsize
+        std::string cpucount;               // -cpucount
+        std::string threads;                // "yes" -> -threads, "no" -> -nothreads
+        std::string bufsize;                // -bufsize
+        std::string work;                   // -work (directory of the WORK library)
+        std::vector<std::string> options;   // Further options, verbatim
+    };
+
+    /**
+     * @brief CPU and memory limits of a cgroup; 0 means unlimited
+     */
+    struct cgroup_limits
+    {
+        double cpus = 0.0;                  // CPU quota in CPUs (quota / period)
+        unsigned long long memory_bytes = 0;
+    };
+
+    /**
+     * @brief Parse a cgroup v2 cpu.max ("max 100000" or "200000 100000")
+     * @return false if unlimited or unparsable
+     */
+    bool parse_cpu_max(const std::string& content, double& cpus);
+
+    /**
+     * @brief Parse cgroup v1 cpu.cfs_quota_us and cpu.cfs_period_us
+     * @return false if unlimited (quota -1) or unparsable
+     */
+    bool parse_cfs_quota(const std::string& quota, const std::string& period, double& cpus);
+
+    /**
+     * @brief Parse memory.max (v2) or memory.limit_in_bytes (v1)
+     *
+     * v1 reports "no limit" as a huge page-aligned number; anything from
+     * 2^60 up counts as unlimited.
+     *
+     * @return false if unlimited or unparsable
+     */
+    bool parse_memory_limit(const std::string& content, unsigned long long& bytes);
+
+    /**
+     * @brief Limits of the cgroup this process runs in
+     *
+     * Understands cgroup v2 (unified) and v1 (cpu and memory controllers).
+     * The tightest limit along the cgroup and its ancestors wins. Inside a
+     * container, where /proc/self/cgroup may name a path of the host, the
+     * root of @p cgroup_root is used.
+     *
+     * @param proc_cgroup Contents source, normally /proc/self/cgroup
+     * @param cgroup_root Mount point of the cgroup file system
+     */
+    cgroup_limits read_cgroup_limits(const std::string& proc_cgroup = "/proc/self/cgroup",
+                                     const std::string& cgroup_root = "/sys/fs/cgroup");
+
+    /**
+     * @brief CPUs this process may run on (affinity mask), at least 1
+     */
+    unsigned available_cpus();
+
+    /**
+     * @brief Profile derived from container limits
+     *
+     * CPUCOUNT is the CPU quota rounded up, capped by @p cpus; THREADS is
+     * on with more than one CPU. MEMSIZE and SORTSIZE are not derived: a
+     * kernel runs an open-ended number of SAS processes (active, standby,
+     * named sessions) under the same memory limit.
+     *
+     * @param cpus CPUs available by affinity
+     */
+    launch_profile derive_launch_profile(const cgroup_limits& limits, unsigned cpus);
+
+    /**
+     * @brief Read a profile from a JSON file
+     *
+     * Keys: "auto" (bool), "memsize", "sortsize", "cpucount", "threads",
+     * "bufsize", "work" (strings or numbers) and "options" (array of
+     * strings). "threads" must be "yes" or "no". A missing file yields
+     * the default profile.
+     *
+     * @throws std::runtime_error if the file exists but is not a valid profile
+     */
+    launch_profile load_launch_profile(const std::string& path);
+
+    /**
+     * @brief Override profile values from the environment
+     *
+     * XEUS_SAS_MEMSIZE, XEUS_SAS_SORTSIZE, XEUS_SAS_CPUCOUNT,
+     * XEUS_SAS_THREADS, XEUS_SAS_BUFSIZE, XEUS_SAS_WORK,
+     * XEUS_SAS_OPTIONS (space-separated, appended) and XEUS_SAS_AUTO_TUNE
+     * (0 disables derivation). These can be set in the kernel spec's "env".
+     * An XEUS_SAS_THREADS other than "yes" or "no" is reported and ignored.
+     */
+    void apply_launch_environment(launch_profile& profile);
+
+    /**
+     * @brief Fill values @p profile leaves empty from @p derived
+     */
+    void fill_launch_profile(launch_profile& profile, const launch_profile& derived);
+
+    /**
+     * @brief The profile SAS is started with
+     *
+     * The file named by XEUS_SAS_LAUNCH_PROFILE, else launch_profile.json
+     * in the installed kernel spec directory; then the environment; then,
+     * unless disabled, values derived from the cgroup for anything unset.
+     * An invalid file is reported and ignored.
+     */
+    launch_profile resolve_launch_profile();
+
+    /**
+     * @brief SAS command line options for @p profile
+     */
+    std::vector<std::string> launch_options(const launch_profile& profile);
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_LAUNCH_PROFILE_HPP
@@ -0,0 +1,155 @@
+#ifndef XEUS_SAS_PROCESS_WATCHDOG_HPP
+#define XEUS_SAS_PROCESS_WATCHDOG_HPP
+
+#include <chrono>
+#include <string>
+
+#include <sys/types.h>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Time limits for one execution
+     *
+     * A zero duration disables the limit.
+     */
+    struct execution_limits
+    {
+        std::chrono::milliseconds soft_deadline{0};   // Warn once the cell has run this long
+        std::chrono::milliseconds hard_deadline{0};   // Abort once the cell has run this long
+        std::chrono::milliseconds hang_timeout{0};    // Abort after this long without any progress
+
+        /**
+         * @brief Limits of @p overrides where set, ours elsewhere
+         */
+        execution_limits merged(const execution_limits& overrides) const;
+    };
+
+    /**
+     * @brief Parse a duration such as "90", "90s", "15m" or "2h"
+     * @throws std::invalid_argument on malformed input
+     */
+    std::chrono::milliseconds parse_duration(const std::string& text);
+
+    /**
+     * @brief Extract utime and stime (clock ticks) from /proc/<pid>/stat content
+     * @return false if the content cannot be parsed
+     */
+    bool parse_proc_stat_times(const std::string& stat,
+                               unsigned long long& user_ticks,
+                               unsigned long long& system_ticks);
+
+    /**
+     * @brief Extract utime + stime (clock ticks) from /proc/<pid>/stat content
+     * @return false if the content cannot be parsed
+     */
+    bool parse_proc_stat_cpu(const std::string& stat, unsigned long long& ticks);
+
+    /**
+     * @brief Read the CPU time used so far by a process
+     * @return false if it is not available (no /proc, process gone)
+     */
+    bool read_process_cpu_ticks(pid_t pid, unsigned long long& ticks);
+
+    /**
+     * @brief Signs of life of a process and its descendants
+     */
+    struct process_activity
+    {
+        unsigned long long cpu_ticks = 0;   // utime + stime, plus that of reaped children
+        unsigned long long io_bytes = 0;    // rchar + wchar (/proc/<pid>/io)
+        bool in_disk_wait = false;          // A process is in state D (I/O, NFS, locks)
+    };
+
+    /**
+     * @brief Extract state, parent PID and CPU time from /proc/<pid>/stat content
+     *
+     * @p ticks is utime + stime + cutime + cstime, so work done by children
+     * that have already been reaped still counts.
+     *
+     * @return false if the content cannot be parsed
+     */
+    bool parse_proc_stat_activity(const std::string& stat, char& state, unsigned long long& ticks);
+
+    /**
+     * @brief Sum the activity of @p pid and all its descendants
+     *
+     * Descendants are found through /proc/<pid>/task/<tid>/children; where
+     * the kernel does not provide those files, only @p pid is sampled. I/O
+     * counters of processes we may not read are skipped.
+     *
+     * @return false if @p pid itself cannot be read
+     */
+    bool read_process_activity(pid_t pid, process_activity& activity);
+
+    /**
+     * @brief What the watchdog decided at a check
+     */
+    enum class watchdog_verdict
+    {
+        running,         // Nothing to report
+        soft_deadline,   // Soft deadline just passed (reported once)
+        hard_deadline,   // Hard deadline passed
+        hung             // No progress of any kind for hang_timeout
+    };
+
+    /**
+     * @brief Tells a long-running SAS step from a hung one
+     *
+     * Output on any stream counts as progress, and so does any sign of life
+     * of the SAS process or its descendants (X command and SYSTASK
+     * children): CPU time, bytes read or written (which includes database
+     * and network traffic), or a process waiting in uninterruptible I/O.
+     * A PROC SORT that writes nothing for an hour is left alone while a
+     * process blocked with an idle CPU is caught after hang_timeout. A step
+     * waiting silently on a remote server (an Oracle query that takes an
+     * hour to return its first row) shows none of these, which is why hang
+     * detection is off unless configured. Where /proc cannot be read, only
+     * output counts.
+     */
+    class execution_watchdog
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        /**
+         * @param pid SAS process to sample (-1 to use output only)
+         * @param limits Limits for this execution
+         * @param started_at Start of the execution
+         */
+        execution_watchdog(pid_t pid, const execution_limits& limits, clock::time_point started_at);
+
+        /**
+         * @brief Record output from SAS
+         */
+        void note_output(clock::time_point now);
+
+        /**
+         * @brief Sample CPU time if due and evaluate the limits
+         */
+        watchdog_verdict check(clock::time_point now);
+
+        /**
+         * @brief Longest the caller may sleep before the next check()
+         */
+        std::chrono::milliseconds next_check(clock::time_point now) const;
+
+        /**
+         * @brief Time since the last output or other progress
+         */
+        clock::duration idle_for(clock::time_point now) const;
+
+    private:
+        pid_t m_pid;
+        execution_limits m_limits;
+        clock::time_point m_started_at;
+        clock::time_point m_last_progress;
+        clock::time_point m_last_sample;
+        process_activity m_activity;
+        bool m_activity_available;
+        bool m_soft_reported;
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_PROCESS_WATCHDOG_HPP
@@ -0,0 +1,96 @@
+#ifndef XEUS_SAS_RESOURCE_USAGE_HPP
+#define XEUS_SAS_RESOURCE_USAGE_HPP
+
+#include <string>
+
+#include <sys/types.h>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Counters of one process at one moment, from /proc/<pid>
+     */
+    struct resource_sample
+    {
+        bool valid = false;                         // stat was readable
+        unsigned long long user_ticks = 0;          // stat: utime
+        unsigned long long system_ticks = 0;        // stat: stime
+        unsigned long long peak_rss_kb = 0;         // status: VmHWM
+        unsigned long long voluntary_switches = 0;  // status: voluntary_ctxt_switches
+        unsigned long long involuntary_switches = 0;
+        bool has_io = false;                        // io was readable (same user only)
+        unsigned long long read_chars = 0;          // io: rchar (all reads, incl. page cache)
+        unsigned long long write_chars = 0;         // io: wchar
+        unsigned long long read_bytes = 0;          // io: read_bytes (from storage)
+        unsigned long long write_bytes = 0;         // io: write_bytes (to storage)
+    };
+
+    /**
+     * @brief What SAS used during one execution
+     */
+    struct resource_usage
+    {
+        bool available = false;                     // Both samples were valid
+        double cpu_user_s = 0.0;
+        double cpu_system_s = 0.0;
+        unsigned long long peak_rss_kb = 0;         // Peak resident set size
+        bool peak_rss_per_cell = false;             // Peak was reset at the start (else process lifetime)
+        unsigned long long voluntary_switches = 0;
+        unsigned long long involuntary_switches = 0;
+        bool has_io = false;
+        unsigned long long read_chars = 0;
+        unsigned long long write_chars = 0;
+        unsigned long long read_bytes = 0;
+        unsigned long long write_bytes = 0;
+    };
+
+    /**
+     * @brief Read /proc/<pid>/<name>, e.g. "stat" or "task/<tid>/children"
+     * @return false if the file is unreadable or empty
+     */
+    bool read_proc_file(pid_t pid, const std::string& name, std::string& content);
+
+    /**
+     * @brief Fill VmHWM and the context switch counts from /proc/<pid>/status content
+     * @return false if none of them is present
+     */
+    bool parse_proc_status(const std::string& status, resource_sample& sample);
+
+    /**
+     * @brief Fill the I/O counters from /proc/<pid>/io content
+     * @return false if the content cannot be parsed
+     */
+    bool parse_proc_io(const std::string& io, resource_sample& sample);
+
+    /**
+     * @brief Sample a process; fields that cannot be read stay zero
+     *
+     * sample.valid is false without /proc or once the process is gone.
+     */
+    resource_sample sample_process(pid_t pid);
+
+    /**
+     * @brief Reset the peak RSS (VmHWM) of a process to its current RSS
+     *
+     * Writes "5" to /proc/<pid>/clear_refs (Linux 4.0+), which needs the
+     * same rights as ptrace.
+     *
+     * @return false if the reset is not possible
+     */
+    bool reset_peak_rss(pid_t pid);
+
+    /**
+     * @brief Usage between two samples of the same process
+     * @param peak_reset Whether reset_peak_rss() succeeded before @p start
+     */
+    resource_usage usage_between(const resource_sample& start, const resource_sample& end, bool peak_reset);
+
+    /**
+     * @brief One-line summary, e.g. "SAS: 4.2 s CPU (3.9 user, 0.3 sys), peak RSS 812 MB, ..."
+     * @param wall_ms Wall time of the execution
+     */
+    std::string format_usage(const resource_usage& usage, double wall_ms);
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_RESOURCE_USAGE_HPP
@@ -0,0 +1,175 @@
+#ifndef XEUS_SAS_BROKER_HPP
+#define XEUS_SAS_BROKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "xeus-sas/event_poller.hpp"
+
+namespace xeus_sas
+{
+    class sas_process;
+
+    /**
+     * @brief Socket of the user's SAS broker: XEUS_SAS_BROKER, or
+     *        xsas-broker.sock in XDG_RUNTIME_DIR (/tmp/xsas-broker-<uid>.sock
+     *        without one)
+     */
+    std::string default_broker_socket();
+
+    /**
+     * @brief Send one protocol line, with descriptors attached (SCM_RIGHTS)
+     * @return false if the socket is closed or the send failed
+     */
+    bool send_message(int socket_fd, const std::string& line, const std::vector<int>& fds = {});
+
+    /**
+     * @brief Read one '\n'-terminated protocol line and the descriptors sent with it
+     *
+     * Received descriptors are close-on-exec. Blocks unless the socket is
+     * non-blocking or has a receive timeout.
+     *
+     * @return false on EOF, error or timeout before a complete line
+     */
+    bool receive_message(int socket_fd, std::string& line, std::vector<int>& fds);
+
+    /**
+     * @brief Limits a broker enforces
+     */
+    struct broker_limits
+    {
+        size_t pool_size = 2;          // Warm processes kept ready for new leases
+        size_t max_processes = 16;     // SAS processes of the broker, leased or warm
+    };
+
+    /**
+     * @brief Lease accounting against the process limit
+     *
+     * Not thread-safe; the broker guards it with its own mutex.
+     */
+    class lease_ledger
+    {
+    public:
+        explicit lease_ledger(const broker_limits& limits);
+
+        /**
+         * @brief Count a lease if the process limit allows it
+         * @param refusal Set to the reason when the lease is refused
+         */
+        bool acquire(std::string& refusal);
+
+        /**
+         * @brief Give back a lease taken with acquire()
+         */
+        void release();
+
+        size_t leased() const;
+
+        /**
+         * @brief How many warm processes to keep
+         *
+         * The pool size plus one per lease still @p waiting for a process,
+         * without leased and warm processes together exceeding the limit.
+         */
+        size_t pool_target(size_t waiting) const;
+
+    private:
+        broker_limits m_limits;
+        size_t m_leased = 0;
+    };
+
+    /**
+     * @brief Per-user pool of warm SAS processes leased to that user's kernels
+     *
+     * Kernels connect to a Unix domain socket and send "LEASE". The broker
+     * answers "OK <pid>" with the process's stdin, stdout, stderr and
+     * listing pipes attached (SCM_RIGHTS), or "ERR <reason>" when a limit
+     * is reached. The connection is the lease: the kernel may send
+     * "INTERRUPT" over it, the broker reports "EXIT <wait status>" when SAS
+     * dies, and closing it makes the broker end SAS and start a
+     * replacement for the pool.
+     *
+     * SAS processes run as the broker's user, in its working directory
+     * and environment, with the broker's launch profile. Peers are
+     * identified by their socket credentials; only the broker's own user
+     * is granted leases, whatever the socket permissions. Each user runs
+     * their own broker, and max_processes caps that user's SAS processes.
+     */
+    class sas_broker
+    {
+    public:
+        /**
+         * @brief Listen on @p socket_path (an existing socket file is replaced)
+         * @param socket_mode Permissions of the socket file
+         * @param sas_options Further SAS options for every process (launch profile)
+         * @throws std::runtime_error if the socket cannot be created
+         */
+        sas_broker(const std::string& sas_path,
+                   const std::string& socket_path,
+                   const broker_limits& limits,
+                   mode_t socket_mode = 0600,
+                   const std::vector<std::string>& sas_options = {});
+
+        /**
+         * @brief Stops the broker and ends all its SAS processes
+         */
+        ~sas_broker();
+
+        sas_broker(const sas_broker&) = delete;
+        sas_broker& operator=(const sas_broker&) = delete;
+
+        /**
+         * @brief Serve leases until stop() is called
+         */
+        void run();
+
+        /**
+         * @brief Make run() return; async-signal-safe
+         */
+        void stop();
+
+    private:
+        struct lease
+        {
+            int socket_fd;
+            uid_t user;
+            std::thread worker;
+            std::atomic<bool> finished{false};
+        };
+
+        void accept_clients();
+        void serve_lease(lease& client);
+        std::unique_ptr<sas_process> take_warm_process();
+        void refill_loop();
+        void prune_leases();
+
+        std::string m_sas_path;
+        std::vector<std::string> m_sas_options;
+        std::string m_socket_path;
+        int m_listen_fd;
+        event_poller m_poller;
+        std::atomic<bool> m_stopping;
+
+        std::mutex m_mutex;                                 // Guards everything below
+        std::condition_variable m_changed;
+        lease_ledger m_ledger;
+        std::deque<std::unique_ptr<sas_process>> m_pool;    // Ready to lease
+        size_t m_starting;                                  // Being started for the pool
+        size_t m_waiting;                                   // Leases granted, no process yet
+        std::list<lease> m_leases;
+        std::thread m_refill;
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_BROKER_HPP
@@ -80,12 +80,24 @@ namespace xeus_sas
     /**
      * @brief Generate a unique execution marker
      *
-     * Used to delimit SAS code blocks for parsing output.
+     * Used to frame the output of one execution. Safe to call from
+     * several threads.
      *
-     * @return Unique marker string
+     * @return "XEUS_SAS_MARKER_" followed by 16 random hex digits
      */
     std::string generate_execution_marker();
 
+    /**
+     * @brief Whether code contains an ODS statement
+     *
+     * Looks for the word ODS (any case) followed by whitespace. Comments
+     * and strings are not skipped, so the answer errs on the side of yes.
+     *
+     * @param code SAS code
+     * @return true if an ODS statement may change ODS destinations or settings
+     */
+    bool touches_ods(const std::string& code);
+
     /**
      * @brief Determine if listing should be shown instead of log
      *
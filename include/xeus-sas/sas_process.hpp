@@ -0,0 +1,156 @@
+#ifndef XEUS_SAS_PROCESS_HPP
+#define XEUS_SAS_PROCESS_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace xeus_sas
+{
+    /**
+     * @brief A running SAS child process and the pipes connected to it
+     *
+     * SAS runs in interactive line mode (-stdio): code is written to its
+     * stdin, ODS/listing output arrives on stdout and the log on stderr.
+     * The stdin pipe is non-blocking so that writers can interleave
+     * writing code with draining output.
+     *
+     * A fourth pipe is inherited by SAS as file descriptor 3 (listing_fd_number)
+     * for listing output redirected with PROC PRINTTO to /dev/fd/3, so it
+     * never touches the disk.
+     *
+     * A process can also be leased from an xsas-broker (see sas_broker.hpp)
+     * instead of being spawned; the broker then owns and reaps it.
+     */
+    class sas_process
+    {
+    public:
+        /**
+         * @brief Start SAS
+         *
+         * SAS is started with posix_spawn in its own process group. All pipes
+         * are close-on-exec, so it inherits no descriptors but its own.
+         *
+         * @param sas_path Path to SAS executable (searched in PATH)
+         * @param options Further SAS options, e.g. from launch_options()
+         * @throws std::runtime_error if the pipes or the child cannot be created
+         */
+        static std::unique_ptr<sas_process> spawn(const std::string& sas_path,
+                                                  const std::vector<std::string>& options = {});
+
+        /**
+         * @brief Lease a warm SAS process from the broker at @p broker_socket
+         *
+         * The broker passes the process's pipes over the socket, which stays
+         * open for the lifetime of the lease. SAS is switched to the
+         * kernel's working directory.
+         *
+         * @throws std::runtime_error if the broker is unreachable or refuses
+         *         the lease (e.g. its process limit is reached)
+         */
+        static std::unique_ptr<sas_process> lease(const std::string& broker_socket);
+
+        /**
+         * @brief Destructor - terminates SAS if still running
+         */
+        ~sas_process();
+
+        sas_process(const sas_process&) = delete;
+        sas_process& operator=(const sas_process&) = delete;
+
+        /**
+         * @brief Block until SAS has finished starting up
+         *
+         * Submits a readiness sentinel and discards everything SAS prints
+         * before it (copyright banner, SASUSER notes), so the first real
+         * execution starts from a clean log.
+         *
+         * @param timeout Maximum time to wait
+         * @throws std::runtime_error on timeout or if SAS exits
+         */
+        void wait_until_ready(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief End SAS, close the pipes and reap the child
+         *
+         * Submits ENDSAS and drains output while SAS shuts down. A SAS that
+         * has not exited after @p grace gets SIGTERM, and SIGKILL after
+         * @p grace more. One still alive @p grace after SIGKILL (stuck in
+         * uninterruptible I/O) is logged and abandoned, so this returns
+         * within about three times @p grace.
+         * Safe to call more than once.
+         */
+        void terminate(std::chrono::milliseconds grace = default_shutdown_grace());
+
+        /**
+         * @brief Interrupt the running step (SIGINT, sent by the broker for a lease)
+         * @return false if the signal or request could not be sent
+         */
+        bool interrupt();
+
+        /**
+         * @brief Check, without blocking, whether SAS has exited
+         *
+         * Reaps the child on the first call that finds it gone.
+         */
+        bool has_exited();
+
+        /**
+         * @brief Wait up to @p timeout (negative = forever) for SAS to exit
+         *
+         * Output arriving meanwhile is read and discarded, so SAS never
+         * blocks on a full pipe.
+         *
+         * @return true once SAS has exited and been reaped
+         */
+        bool wait_for_exit(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief How SAS ended, e.g. "exited with status 2" or "killed by signal 9"
+         *
+         * Only meaningful once has_exited() returned true.
+         */
+        std::string exit_description() const;
+
+        /**
+         * @brief Raw wait status once SAS has exited; -1 if unknown
+         */
+        int exit_status() const;
+
+        /**
+         * @brief Grace period per shutdown stage (XEUS_SAS_SHUTDOWN_GRACE, default 5s)
+         */
+        static std::chrono::milliseconds default_shutdown_grace();
+
+        pid_t pid() const;
+        int input_fd() const;      // SAS stdin (non-blocking)
+        int output_fd() const;     // SAS stdout (ODS/listing)
+        int log_fd() const;        // SAS stderr (log)
+        int listing_fd() const;    // SAS fd 3 (redirected listing)
+        int exit_fd() const;       // Readable once SAS exits (pidfd or lease; -1 if unsupported)
+
+        /**
+         * @brief Descriptor number under which SAS sees the listing pipe
+         */
+        static const int listing_fd_number = 3;
+
+    private:
+        sas_process() = default;
+
+        pid_t m_pid = -1;
+        int m_stdin_fd = -1;
+        int m_stdout_fd = -1;
+        int m_stderr_fd = -1;
+        int m_listing_fd = -1;
+        int m_pidfd = -1;
+        int m_lease_fd = -1;       // Connection to the broker for a leased process
+        bool m_exited = false;
+        int m_exit_status = 0;
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_PROCESS_HPP
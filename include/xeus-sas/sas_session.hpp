@@ -4,6 +4,11 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <functional>
+#include <future>
+
+#include "xeus-sas/process_watchdog.hpp"
+#include "xeus-sas/resource_usage.hpp"
 
 namespace xeus_sas
 {
@@ -24,8 +29,38 @@ namespace xeus_sas
         int error_code;                       // SAS error code
         std::string error_message;            // Error details
         std::vector<std::string> graph_files; // Generated graphics (PNG/SVG)
+        double sas_time_ms = 0.0;             // Submission until SAS reached the end sentinel
+        double drain_time_ms = 0.0;           // First sentinel until both streams were drained
+        resource_usage resources;             // CPU, memory and I/O of SAS for this execution
+    };
+
+    /**
+     * @brief Kind of output delivered while SAS is still running
+     */
+    enum class output_kind
+    {
+        log,     // One or more complete SAS log lines
+        html,    // One finished ODS output object, already post-processed
+        graph,   // Path of a graphics file announced in the log
+        notice   // Message from the kernel about the execution (e.g. soft deadline)
+    };
+
+    /**
+     * @brief A piece of output handed to an output_callback
+     */
+    struct output_chunk
+    {
+        output_kind kind;
+        std::string text;
     };
 
+    /**
+     * @brief Receives output as it arrives during execute()
+     *
+     * Called on the session's reader thread, in stream order per kind.
+     */
+    using output_callback = std::function<void(const output_chunk&)>;
+
     /**
      * @brief Manages SAS process lifecycle and communication
      *
@@ -53,6 +88,15 @@ namespace xeus_sas
         sas_session(const sas_session&) = delete;
         sas_session& operator=(const sas_session&) = delete;
 
+        /**
+         * @brief Start SAS on a background thread
+         *
+         * Returns immediately. The startup banner is drained and discarded;
+         * the first execute() waits for startup to finish. Without a call
+         * to start(), SAS is started by the first execute().
+         */
+        void start();
+
         /**
          * @brief Execute SAS code and return result
          * @param code SAS code to execute
@@ -60,6 +104,58 @@ namespace xeus_sas
          */
         execution_result execute(const std::string& code);
 
+        /**
+         * @brief Execute SAS code, streaming output while SAS runs
+         *
+         * Log lines, finished HTML output objects and graphics are passed to
+         * @p on_output as soon as they are complete. HTML handed to the
+         * callback is not kept, so the returned result has an empty
+         * html_output (has_html still reports whether any was produced).
+         * The log is still returned in full for error reporting.
+         *
+         * @param code SAS code to execute
+         * @param on_output Output receiver (may be empty for buffered mode)
+         * @return execution_result with log, listing and error info
+         */
+        execution_result execute(const std::string& code, const output_callback& on_output);
+
+        /**
+         * @brief Queue SAS code without waiting for the previous block
+         *
+         * The wrapped code and its sentinels are written to SAS right away,
+         * so SAS can start on this block while the caller is still handling
+         * the output of earlier ones. A reader thread collects the output
+         * of each block in submission order and fulfils its future;
+         * @p on_output is called from that thread.
+         *
+         * If a block is interrupted or its output cannot be read, all blocks
+         * queued after it complete with an error result.
+         *
+         * A watchdog applies @p limits (merged over the session's limits):
+         * a cell is only treated as hung when neither SAS nor its children
+         * write output, use CPU or do I/O for hang_timeout. When it aborts a cell, SAS is replaced
+         * before the next submission so the streams start in step again.
+         *
+         * @param code SAS code to execute
+         * @param on_output Output receiver (may be empty for buffered mode)
+         * @param limits Per-cell limits; zero fields keep the session's
+         * @param checkpoint_after Checkpoint once this block succeeds (see
+         *        take_due_checkpoint())
+         * @return Future for the execution_result
+         */
+        std::future<execution_result> submit(const std::string& code,
+                                             const output_callback& on_output,
+                                             const execution_limits& limits = execution_limits(),
+                                             bool checkpoint_after = false);
+
+        /**
+         * @brief Set the watchdog limits used by every cell of this session
+         *
+         * Defaults come from XEUS_SAS_SOFT_DEADLINE, XEUS_SAS_HARD_DEADLINE
+         * and XEUS_SAS_HANG_TIMEOUT; limits not configured there are off.
+         */
+        void set_limits(const execution_limits& limits);
+
         /**
          * @brief Get SAS version string
          * @return SAS version (e.g., "9.4")
@@ -68,7 +164,8 @@ namespace xeus_sas
 
         /**
          * @brief Check if session is ready for execution
-         * @return true if SAS process is running and responsive
+         * @return true once a SAS process has started and answered the
+         *         readiness check
          */
         bool is_ready() const;
 
@@ -79,17 +176,65 @@ namespace xeus_sas
 
         /**
          * @brief Interrupt current execution (SIGINT)
+         *
+         * Also wakes a concurrent execute() so that it stops waiting for
+         * output immediately.
          */
         void interrupt();
 
         /**
          * @brief Restart the SAS session
          *
-         * Kills the current SAS process and starts a fresh one.
-         * WARNING: This loses all session state (datasets, macro variables).
+         * Kills the current SAS process and starts a fresh one. Session
+         * state (datasets, macro variables) is lost, except what the last
+         * checkpoint holds: it is replayed before the next execution.
          */
         void restart();
 
+        /**
+         * @brief Enable checkpoints of WORK and the global macro variables
+         *
+         * Checkpoints are taken by checkpoint(), after cells submitted with
+         * checkpoint_after, and with XEUS_SAS_CHECKPOINT=cell after every
+         * successful cell (see take_due_checkpoint()). Whenever a new SAS process
+         * replaces the current one (restart, watchdog abort, crash), the
+         * last checkpoint is replayed into it before the next execution.
+         *
+         * With XEUS_SAS_IDLE_TIMEOUT set, an idle session also saves its
+         * state (including options, librefs and filerefs) under
+         * @p directory/hibernate and ends SAS; the next execution starts a
+         * new process, restores that state and reports how long it took.
+         *
+         * @param directory Checkpoint directory for this session
+         * @param restore_existing Replay a checkpoint already in @p directory
+         *        (e.g. from an earlier kernel) before the first execution;
+         *        otherwise it is deleted
+         */
+        void set_checkpoint_dir(const std::string& directory, bool restore_existing = false);
+
+        /**
+         * @brief Take a checkpoint now, once queued executions have finished
+         * @return false if checkpoints are disabled or the checkpoint failed
+         */
+        bool checkpoint();
+
+        /**
+         * @brief Take the checkpoint due after a successful cell, if any
+         *
+         * A cell submitted with checkpoint_after (or any cell, with
+         * XEUS_SAS_CHECKPOINT=cell) makes a checkpoint due when it succeeds.
+         * It is taken by this call or, if that comes first, by the next
+         * submit() before the next cell reaches SAS.
+         *
+         * @return true if a checkpoint was taken
+         */
+        bool take_due_checkpoint();
+
+        /**
+         * @brief Whether a checkpoint exists to restore after a restart
+         */
+        bool has_checkpoint() const;
+
         /**
          * @brief Get value of a SAS macro variable
          * @param name Macro variable name (without %)
@@ -0,0 +1,136 @@
+#ifndef XEUS_SAS_SCRATCH_DIRECTORY_HPP
+#define XEUS_SAS_SCRATCH_DIRECTORY_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Marks a directory as in use for as long as the object lives
+     *
+     * Holds an flock on <directory>/.xeus-sas.lock. Unlike a PID, the lock
+     * is seen by kernels in other PID namespaces or on other hosts sharing
+     * the file system, and it is released by the OS when the owner dies.
+     */
+    class directory_lock
+    {
+    public:
+        static constexpr const char* file_name = ".xeus-sas.lock";
+
+        directory_lock() = default;
+
+        /**
+         * @brief Releases the lock
+         */
+        ~directory_lock();
+
+        directory_lock(const directory_lock&) = delete;
+        directory_lock& operator=(const directory_lock&) = delete;
+
+        /**
+         * @brief Lock @p directory, which must exist
+         * @throws std::runtime_error if the lock file cannot be created or locked
+         */
+        void acquire(const std::string& directory);
+
+        /**
+         * @brief Give the lock up (no-op if not held)
+         */
+        void release();
+
+        bool held() const;
+
+    private:
+        int m_fd = -1;
+    };
+
+    /**
+     * @brief Private temporary directory of one SAS session
+     *
+     * Created with mkdtemp as <base>/xeus-sas-<pid>-XXXXXX (mode 0700). It
+     * holds the session's temporary files and, in "work", the directory
+     * SAS is started with -work on, so WORK libraries live on the same
+     * file system. The directory is locked (directory_lock) while it
+     * exists. The whole tree is removed when the session ends; directories
+     * of kernels that died are removed by sweep_orphaned_directories()
+     * when the next kernel starts.
+     */
+    class scratch_directory
+    {
+    public:
+        /**
+         * @brief Base for scratch directories
+         *
+         * XEUS_SAS_SCRATCH_DIR ("tmpfs" selects /dev/shm), else TMPDIR,
+         * else /tmp.
+         */
+        static std::string default_base();
+
+        /**
+         * @brief Create a new scratch directory under @p base
+         * @throws std::runtime_error if it cannot be created
+         */
+        explicit scratch_directory(const std::string& base = default_base());
+
+        /**
+         * @brief Removes the directory tree
+         */
+        ~scratch_directory();
+
+        scratch_directory(const scratch_directory&) = delete;
+        scratch_directory& operator=(const scratch_directory&) = delete;
+
+        /**
+         * @brief Name prefix of scratch directories, followed by the kernel's PID
+         */
+        static constexpr const char* name_prefix = "xeus-sas-";
+
+        const std::string& path() const;
+
+        /**
+         * @brief Directory to pass to SAS as -work
+         */
+        std::string work_dir() const;
+
+        /**
+         * @brief Path of a file directly in the scratch directory
+         */
+        std::string file(const std::string& name) const;
+
+        /**
+         * @brief Whether the directory is on tmpfs (RAM-backed)
+         */
+        bool on_tmpfs() const;
+
+        /**
+         * @brief Recreate and lock the directory after remove(), at the same path
+         * @throws std::runtime_error if it cannot be created
+         */
+        void ensure();
+
+        /**
+         * @brief Remove the directory tree; SAS must no longer be using it
+         */
+        void remove();
+
+    private:
+        std::string m_path;
+        directory_lock m_lock;
+    };
+
+    /**
+     * @brief Remove directories of kernels that are no longer running
+     *
+     * Entries of @p base named @p prefix followed by a process ID (and
+     * optionally "-" and more) are removed when their directory_lock file
+     * exists and nobody holds the lock. Directories without a lock file
+     * are left alone: their owner may be just creating it.
+     *
+     * @return Number of directories removed
+     */
+    size_t sweep_orphaned_directories(const std::string& base, const std::string& prefix);
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_SCRATCH_DIRECTORY_HPP
@@ -0,0 +1,136 @@
+#ifndef XEUS_SAS_SESSION_MANAGER_HPP
+#define XEUS_SAS_SESSION_MANAGER_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "xeus-sas/process_watchdog.hpp"
+#include "xeus-sas/scratch_directory.hpp"
+
+namespace xeus_sas
+{
+    class sas_session;
+
+    /**
+     * @brief Session selection and limits parsed from a cell
+     */
+    struct cell_target
+    {
+        std::string session;       // Session name (default_session_name if none given)
+        execution_limits limits;   // Per-cell watchdog limits (zero = session default)
+        bool checkpoint = false;   // Checkpoint the session after the cell succeeds
+        std::string code;          // Cell code with the magic lines removed
+    };
+
+    /**
+     * @brief Parse the kernel magics at the top of a cell
+     *
+     * Recognized lines, in any order before the SAS code:
+     * - "%%session <name>": run in the named session. Names may contain
+     *   letters, digits, '_' and '-'.
+     * - "%%limits soft=<t> hard=<t> hang=<t>": watchdog limits for this
+     *   cell (any subset; durations like 90, 90s, 15m, 2h).
+     * - "%%checkpoint": checkpoint WORK and the macro variables once the
+     *   cell has run successfully.
+     *
+     * Leading blank lines are skipped; other "%%" lines are left for SAS.
+     *
+     * @param code Cell code
+     * @return Target session, limits and the code to run
+     * @throws std::invalid_argument if a magic is present but malformed
+     */
+    cell_target parse_cell_magics(const std::string& code);
+
+    /**
+     * @brief Owns the named SAS sessions of a kernel
+     *
+     * Each session has its own SAS process and worker thread. Jobs for the
+     * same session run in submission order; jobs for different sessions run
+     * concurrently. Sessions are created and started on first use.
+     *
+     * Each session checkpoints into <root>/<name>, where the root is
+     * XEUS_SAS_CHECKPOINT_DIR or a per-kernel directory in
+     * scratch_directory::default_base() that is removed at shutdown. With
+     * XEUS_SAS_CHECKPOINT_RESTORE=1, checkpoints found there are replayed
+     * when a session starts.
+     */
+    class session_manager
+    {
+    public:
+        using job = std::function<void(sas_session&)>;
+        using drop_handler = std::function<void()>;
+
+        /**
+         * @brief Construct the manager
+         * @param sas_path Path to SAS executable (empty = auto-detect)
+         */
+        explicit session_manager(const std::string& sas_path = "");
+
+        /**
+         * @brief Destructor - stops workers and shuts all sessions down
+         */
+        ~session_manager();
+
+        session_manager(const session_manager&) = delete;
+        session_manager& operator=(const session_manager&) = delete;
+
+        /**
+         * @brief Get a session, creating and starting it if needed
+         * @param name Session name
+         */
+        sas_session& get(const std::string& name);
+
+        /**
+         * @brief Queue work on a session's worker thread
+         *
+         * @param name Session name (created if needed)
+         * @param work Job to run with the session
+         * @param on_drop Called instead of the job if shutdown() drops it
+         *                (e.g. to answer the request that queued it)
+         */
+        void submit(const std::string& name, job work, drop_handler on_drop = nullptr);
+
+        /**
+         * @brief Whether a session has a job running or queued
+         * @param name Session name (false if it does not exist)
+         */
+        bool busy(const std::string& name) const;
+
+        /**
+         * @brief Names of all sessions created so far
+         */
+        std::vector<std::string> names() const;
+
+        /**
+         * @brief Stop all workers and shut every session down
+         *
+         * Jobs still queued are dropped; their drop handlers are called.
+         */
+        void shutdown();
+
+    private:
+        struct worker;
+
+        std::string m_sas_path;
+        std::string m_checkpoint_root;
+        bool m_owns_checkpoint_root;
+        directory_lock m_checkpoint_lock;       // Held on an owned root until it is removed
+        bool m_restore_checkpoints;
+        mutable std::mutex m_mutex;
+        std::map<std::string, std::unique_ptr<worker>> m_workers;
+
+        worker& get_worker(const std::string& name);
+    };
+
+    /**
+     * @brief Name of the session used by cells without a session magic
+     */
+    extern const char* const default_session_name;
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_SESSION_MANAGER_HPP
@@ -0,0 +1,72 @@
+#ifndef XEUS_SAS_STREAM_SCANNER_HPP
+#define XEUS_SAS_STREAM_SCANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Occurrence of a pattern in a scanned stream
+     */
+    struct scan_match
+    {
+        size_t pattern;    // Index into the scanner's pattern list
+        size_t offset;     // Stream offset of the first byte of the match
+    };
+
+    /**
+     * @brief Incremental multi-pattern matcher (Aho-Corasick automaton)
+     *
+     * Patterns are compiled into a byte-level DFA once. feed() then looks
+     * at every byte exactly once and keeps its state between calls, so a
+     * pattern split across two pipe reads is still found and the cost is
+     * O(total bytes) regardless of how the data is chunked.
+     */
+    class stream_scanner
+    {
+    public:
+        /**
+         * @brief Compile the automaton
+         * @param patterns Non-empty byte strings to look for
+         */
+        explicit stream_scanner(const std::vector<std::string>& patterns);
+
+        /**
+         * @brief Scan the next chunk of the stream
+         *
+         * @param data Chunk bytes
+         * @param length Chunk length
+         * @param matches Output: matches ending in this chunk are appended,
+         *                in stream order
+         */
+        void feed(const char* data, size_t length, std::vector<scan_match>& matches);
+
+        /**
+         * @brief Forget stream state (offset and partial matches)
+         */
+        void reset();
+
+        /**
+         * @brief Total number of bytes fed since construction or reset()
+         */
+        size_t bytes_scanned() const;
+
+        /**
+         * @brief Length of pattern @p index
+         */
+        size_t pattern_length(size_t index) const;
+
+    private:
+        std::vector<std::string> m_patterns;
+        std::vector<int32_t> m_transitions;        // state * 256 + byte -> state
+        std::vector<std::vector<size_t>> m_output; // Patterns ending in each state
+        int32_t m_state;
+        size_t m_offset;
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_STREAM_SCANNER_HPP
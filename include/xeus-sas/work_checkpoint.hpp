@@ -0,0 +1,109 @@
+#ifndef XEUS_SAS_WORK_CHECKPOINT_HPP
+#define XEUS_SAS_WORK_CHECKPOINT_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace xeus_sas
+{
+    /**
+     * @brief What a WORK snapshot or restore did
+     */
+    struct checkpoint_stats
+    {
+        size_t cloned = 0;      // Members reflinked (copy-on-write clone of the blocks)
+        size_t copied = 0;      // Members copied byte by byte (no reflink support)
+        size_t unchanged = 0;   // Members already in the snapshot
+        size_t removed = 0;     // Snapshot members no longer in WORK
+    };
+
+    /**
+     * @brief Whether a file in a SAS library directory is a library member
+     *
+     * Members are data sets, views, catalogs (including WORK.SASMACR with
+     * compiled macros and WORK.FORMATS) and indexes. Lock files of members
+     * being written are not.
+     */
+    bool is_library_member(const std::string& file_name);
+
+    /**
+     * @brief Bring a snapshot directory up to date with a WORK directory
+     *
+     * Each snapshot member is a file of its own, never a hard link: SAS
+     * updates data sets, catalogs and indexes in place (PROC APPEND, MODIFY,
+     * SQL INSERT, WORK.FORMATS), and an update interrupted halfway must not
+     * reach the snapshot. Members are reflinked where the file system
+     * supports it (XFS, Btrfs), which shares blocks copy-on-write, and
+     * copied otherwise. A member whose size and modification time match
+     * the snapshot's is left alone. Snapshot members that are gone from
+     * WORK are removed.
+     *
+     * @throws std::runtime_error if a directory cannot be read or created
+     */
+    checkpoint_stats sync_work_snapshot(const std::string& work_dir, const std::string& snapshot_dir);
+
+    /**
+     * @brief Copy snapshot members into a (new) WORK directory
+     *
+     * Members are cloned or copied, never linked, so the new SAS process
+     * cannot modify the snapshot. Members already present in WORK are kept.
+     *
+     * @throws std::runtime_error if a directory cannot be read
+     */
+    checkpoint_stats restore_work_snapshot(const std::string& snapshot_dir, const std::string& work_dir);
+
+    /**
+     * @brief Create a directory and its parents (like mkdir -p)
+     * @throws std::runtime_error on failure
+     */
+    void make_directories(const std::string& path);
+
+    /**
+     * @brief Remove a directory tree; missing paths are ignored
+     */
+    void remove_tree(const std::string& path);
+
+    /**
+     * @brief SAS statement that writes the WORK path to the log
+     *
+     * The log line is picked up by parse_work_path().
+     */
+    std::string work_path_probe_code();
+
+    /**
+     * @brief Extract the WORK path announced by work_path_probe_code()
+     * @return Empty if the log has no such line
+     */
+    std::string parse_work_path(const std::string& log);
+
+    /**
+     * @brief SAS code saving the global macro symbol table into a checkpoint
+     *
+     * Global macro variables (SASHELP.VMACRO, scope GLOBAL, except SYS*)
+     * are stored as data set MACROS in @p checkpoint_dir.
+     */
+    std::string save_macros_code(const std::string& checkpoint_dir);
+
+    /**
+     * @brief SAS code redefining the macro variables saved by save_macros_code()
+     */
+    std::string restore_macros_code(const std::string& checkpoint_dir);
+
+    /**
+     * @brief SAS code saving system options, librefs and filerefs
+     *
+     * Options are stored with PROC OPTSAVE as data set OPTIONS; LIBNAME and
+     * FILENAME statements re-creating the user's librefs and filerefs are
+     * written to settings.sas, both in @p checkpoint_dir. Engine options
+     * given on the original statements (e.g. ACCESS=READONLY) are not kept.
+     */
+    std::string save_settings_code(const std::string& checkpoint_dir);
+
+    /**
+     * @brief SAS code reloading the settings saved by save_settings_code()
+     */
+    std::string restore_settings_code(const std::string& checkpoint_dir);
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_WORK_CHECKPOINT_HPP
@@ -13,6 +13,13 @@
     #define XEUS_SAS_DEFAULT_PATH ""
 #endif
 
+// Installed kernel spec directory (launch profile)
+#ifdef KERNELSPEC_INSTALL_DIR
+    #define XEUS_SAS_KERNELSPEC_DIR KERNELSPEC_INSTALL_DIR
+#else
+    #define XEUS_SAS_KERNELSPEC_DIR ""
+#endif
+
 namespace xeus_sas
 {
     // Version information
@@ -23,6 +30,9 @@ namespace xeus_sas
 
     // Default SAS path
     constexpr const char* default_sas_path = XEUS_SAS_DEFAULT_PATH;
+
+    // Where the kernel spec and its launch_profile.json are installed
+    constexpr const char* kernelspec_dir = XEUS_SAS_KERNELSPEC_DIR;
 }
 
 #endif // XEUS_SAS_CONFIG_HPP
@@ -2,8 +2,10 @@
 #define XEUS_SAS_INTERPRETER_HPP
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <atomic>
+#include <thread>
 
 #include "xeus/xinterpreter.hpp"
 #include "nlohmann/json.hpp"
@@ -14,9 +16,16 @@ namespace nl = nlohmann;
 // Defined in main.cpp, accessed by interpreter
 extern std::atomic<bool> g_interrupt_requested;
 
+// Read end of the self-pipe the SIGINT handler writes to (-1 if unavailable)
+// Defined in main.cpp
+extern int g_interrupt_fd;
+
 namespace xeus_sas
 {
     class sas_session;
+    class session_manager;
+    class event_poller;
+    struct execution_result;
     class completion_engine;
     class inspection_engine;
 
@@ -52,10 +61,14 @@ namespace xeus_sas
         /**
          * @brief Handle interrupt request
          *
-         * Called when SIGINT is received. Restarts the SAS session to recover
-         * from interrupt (since SAS batch mode doesn't support graceful interrupt).
+         * Called by the interrupt watcher as soon as SIGINT is received.
+         * Aborts running and queued cells (their replies go out
+         * immediately) and restarts each session that had any, to recover
+         * from interrupt (since SAS batch mode doesn't support graceful
+         * interrupt). Idle sessions are left alone.
          *
-         * WARNING: This will lose all SAS session state (datasets, macro variables).
+         * WARNING: Restarted sessions lose their state (datasets, macro
+         * variables) except what their last checkpoint holds.
          */
         void handle_interrupt();
 
@@ -70,6 +83,12 @@ namespace xeus_sas
         /**
          * @brief Execute SAS code
          *
+         * The cell is written to the session selected by an optional
+         * "%%session <name>" first line without waiting for earlier cells;
+         * the reply is sent from that session's worker once SAS has
+         * finished. Output published from there carries this request's
+         * parent header (see publish_parent_scope).
+         *
          * @param cb Callback to send reply
          * @param execution_counter Execution number (for In[n]/Out[n])
          * @param code SAS code to execute
@@ -143,10 +162,38 @@ namespace xeus_sas
 
     private:
         // Core components
-        std::unique_ptr<sas_session> m_session;
+        std::unique_ptr<session_manager> m_sessions;
         std::unique_ptr<completion_engine> m_completer;
         std::unique_ptr<inspection_engine> m_inspector;
 
+        // Serializes publishing and replies from concurrent session workers
+        std::mutex m_publish_mutex;
+
+        // Waits on g_interrupt_fd and handles interrupts while cells run
+        std::unique_ptr<event_poller> m_interrupt_poller;
+        std::thread m_interrupt_watcher;
+        std::atomic<bool> m_stopping;
+        std::mutex m_interrupt_mutex;
+
+        void watch_interrupts();
+        void stop_interrupt_watcher();
+
+        /**
+         * @brief Publish the final output of a cell and send its reply
+         *
+         * Runs on the session's worker thread.
+         *
+         * @param streamed_log Whether the log was already streamed live
+         */
+        void publish_result(
+            xeus::xinterpreter::send_reply_callback cb,
+            int execution_counter,
+            const execution_result& result,
+            bool streamed_log,
+            xeus::execute_request_config config,
+            nl::json user_expressions
+        );
+
         /**
          * @brief Display graphics in notebook
          *
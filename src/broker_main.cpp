@@ -0,0 +1,133 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "xeus-sas/sas_broker.hpp"
+#include "xeus-sas/launch_profile.hpp"
+#include "xeus-sas/xeus_sas_config.hpp"
+
+// Broker served by main(), stopped by the signal handler
+static xeus_sas::sas_broker* g_broker = nullptr;
+
+/**
+ * @brief SIGINT/SIGTERM handler: make the broker's run() return
+ *
+ * stop() only sets a flag and wakes the event loop, which is
+ * async-signal-safe; the broker ends its SAS processes on the way out.
+ */
+void stop_handler(int /* signal */)
+{
+    if (g_broker)
+    {
+        g_broker->stop();
+    }
+}
+
+static void usage()
+{
+    std::cerr << "Usage: xsas-broker [--socket PATH] [--sas PATH] [--pool N]\n"
+                 "                   [--max-processes N] [--socket-mode OCTAL]\n"
+                 "\n"
+                 "Keeps warm SAS processes and leases them to the xeus-sas kernels of\n"
+                 "the same user started with XEUS_SAS_BROKER set to the same socket\n"
+                 "(default: XEUS_SAS_BROKER, or xsas-broker.sock in XDG_RUNTIME_DIR).\n"
+                 "SAS options come from the launch profile (XEUS_SAS_LAUNCH_PROFILE,\n"
+                 "XEUS_SAS_MEMSIZE, ...), as for the kernel.\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::string socket_path = xeus_sas::default_broker_socket();
+    const char* sas_env = std::getenv("SAS_PATH");
+    std::string sas_path = sas_env ? sas_env : xeus_sas::default_sas_path;
+    xeus_sas::broker_limits limits;
+    mode_t socket_mode = 0600;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string option = argv[i];
+            if (option == "-h" || option == "--help")
+            {
+                usage();
+                return 0;
+            }
+            if (i + 1 >= argc)
+            {
+                usage();
+                return 1;
+            }
+
+            std::string value = argv[++i];
+            if (option == "--socket")
+            {
+                socket_path = value;
+            }
+            else if (option == "--sas")
+            {
+                sas_path = value;
+            }
+            else if (option == "--pool")
+            {
+                limits.pool_size = std::stoul(value);
+            }
+            else if (option == "--max-processes")
+            {
+                limits.max_processes = std::stoul(value);
+            }
+            else if (option == "--socket-mode")
+            {
+                socket_mode = static_cast<mode_t>(std::stoul(value, nullptr, 8));
+            }
+            else
+            {
+                usage();
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        usage();
+        return 1;
+    }
+
+    if (sas_path.empty())
+    {
+        std::cerr << "SAS executable not found. Please set SAS_PATH or pass --sas." << std::endl;
+        return 1;
+    }
+
+    // Writes to a SAS process or kernel that has gone away must fail with
+    // EPIPE instead of killing the broker
+    signal(SIGPIPE, SIG_IGN);
+
+    try
+    {
+        // The broker's own cgroup bounds the SAS processes it starts
+        std::vector<std::string> sas_options = xeus_sas::launch_options(xeus_sas::resolve_launch_profile());
+        xeus_sas::sas_broker broker(sas_path, socket_path, limits, socket_mode, sas_options);
+        g_broker = &broker;
+
+        struct sigaction sa;
+        sa.sa_handler = stop_handler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+
+        broker.run();
+        g_broker = nullptr;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "xsas-broker: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
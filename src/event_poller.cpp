@@ -0,0 +1,226 @@
+#include "xeus-sas/event_poller.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace xeus_sas
+{
+    event_poller::event_poller()
+        : m_epoll_fd(-1)
+        , m_wake_read_fd(-1)
+        , m_wake_write_fd(-1)
+    {
+#ifdef __linux__
+        m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (m_epoll_fd < 0)
+        {
+            throw std::runtime_error("Failed to create epoll instance");
+        }
+
+        m_wake_read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_wake_read_fd < 0)
+        {
+            close(m_epoll_fd);
+            throw std::runtime_error("Failed to create wakeup eventfd");
+        }
+        m_wake_write_fd = m_wake_read_fd;
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = m_wake_read_fd;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_read_fd, &ev);
+#else
+        int wake_pipe[2];
+        if (pipe(wake_pipe) != 0)
+        {
+            throw std::runtime_error("Failed to create wakeup pipe");
+        }
+        for (int fd : wake_pipe)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        m_wake_read_fd = wake_pipe[0];
+        m_wake_write_fd = wake_pipe[1];
+#endif
+    }
+
+    event_poller::~event_poller()
+    {
+        if (m_epoll_fd >= 0)
+        {
+            close(m_epoll_fd);
+        }
+        if (m_wake_write_fd >= 0 && m_wake_write_fd != m_wake_read_fd)
+        {
+            close(m_wake_write_fd);
+        }
+        if (m_wake_read_fd >= 0)
+        {
+            close(m_wake_read_fd);
+        }
+    }
+
+    void event_poller::add(int fd, bool want_read, bool want_write)
+    {
+        remove(fd);
+        m_registrations.push_back({fd, want_read, want_write});
+
+#ifdef __linux__
+        struct epoll_event ev = {};
+        ev.events = (want_read ? EPOLLIN : 0u) | (want_write ? EPOLLOUT : 0u);
+        ev.data.fd = fd;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            m_registrations.pop_back();
+            throw std::runtime_error("Failed to watch descriptor " + std::to_string(fd));
+        }
+#endif
+    }
+
+    void event_poller::modify(int fd, bool want_read, bool want_write)
+    {
+        auto it = std::find_if(m_registrations.begin(), m_registrations.end(),
+                               [fd](const registration& r) { return r.fd == fd; });
+        if (it == m_registrations.end())
+        {
+            add(fd, want_read, want_write);
+            return;
+        }
+        if (it->want_read == want_read && it->want_write == want_write)
+        {
+            return;
+        }
+        it->want_read = want_read;
+        it->want_write = want_write;
+
+#ifdef __linux__
+        struct epoll_event ev = {};
+        ev.events = (want_read ? EPOLLIN : 0u) | (want_write ? EPOLLOUT : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+#endif
+    }
+
+    void event_poller::remove(int fd)
+    {
+        auto it = std::find_if(m_registrations.begin(), m_registrations.end(),
+                               [fd](const registration& r) { return r.fd == fd; });
+        if (it == m_registrations.end())
+        {
+            return;
+        }
+        m_registrations.erase(it);
+
+#ifdef __linux__
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+    }
+
+    bool event_poller::wait(std::vector<poll_event>& events, int timeout_ms)
+    {
+        events.clear();
+        bool woken = false;
+
+#ifdef __linux__
+        struct epoll_event ready[8];
+        int n = epoll_wait(m_epoll_fd, ready, 8, timeout_ms);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                return false;
+            }
+            throw std::runtime_error("epoll_wait failed");
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            if (ready[i].data.fd == m_wake_read_fd)
+            {
+                woken = true;
+                continue;
+            }
+            poll_event ev;
+            ev.fd = ready[i].data.fd;
+            ev.readable = (ready[i].events & EPOLLIN) != 0;
+            ev.writable = (ready[i].events & EPOLLOUT) != 0;
+            ev.hangup = (ready[i].events & (EPOLLHUP | EPOLLERR)) != 0;
+            events.push_back(ev);
+        }
+#else
+        std::vector<struct pollfd> fds;
+        fds.reserve(m_registrations.size() + 1);
+        fds.push_back({m_wake_read_fd, POLLIN, 0});
+        for (const auto& r : m_registrations)
+        {
+            short mask = (r.want_read ? POLLIN : 0) | (r.want_write ? POLLOUT : 0);
+            fds.push_back({r.fd, mask, 0});
+        }
+
+        int n = poll(fds.data(), fds.size(), timeout_ms);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                return false;
+            }
+            throw std::runtime_error("poll failed");
+        }
+
+        woken = (fds[0].revents & POLLIN) != 0;
+        for (size_t i = 1; i < fds.size(); ++i)
+        {
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+            poll_event ev;
+            ev.fd = fds[i].fd;
+            ev.readable = (fds[i].revents & POLLIN) != 0;
+            ev.writable = (fds[i].revents & POLLOUT) != 0;
+            ev.hangup = (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+            events.push_back(ev);
+        }
+#endif
+
+        if (woken)
+        {
+            drain_wakeups();
+        }
+        return woken;
+    }
+
+    void event_poller::wake()
+    {
+#ifdef __linux__
+        const uint64_t one = 1;
+        ssize_t ignored = write(m_wake_write_fd, &one, sizeof(one));
+#else
+        const char one = 1;
+        ssize_t ignored = write(m_wake_write_fd, &one, sizeof(one));
+#endif
+        (void)ignored;
+    }
+
+    void event_poller::drain_wakeups()
+    {
+        char buffer[64];
+        while (read(m_wake_read_fd, buffer, sizeof(buffer)) > 0)
+        {
+        }
+    }
+
+} // namespace xeus_sas
@@ -0,0 +1,147 @@
+#include "xeus-sas/html_pipeline.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <utility>
+
+namespace xeus_sas
+{
+    namespace
+    {
+        std::string clean_or_raw(const html_pipeline::cleaner& clean, std::string& block)
+        {
+            try
+            {
+                return clean(block);
+            }
+            catch (const std::exception& e)
+            {
+                // Unsimplified output beats no output
+                std::cerr << "HTML post-processing failed, publishing raw block: " << e.what() << std::endl;
+                return std::move(block);
+            }
+        }
+    }
+
+    size_t html_pipeline::default_workers()
+    {
+        const char* workers_env = std::getenv("XEUS_SAS_HTML_WORKERS");
+        if (workers_env)
+        {
+            try
+            {
+                return static_cast<size_t>(std::max(0, std::stoi(workers_env)));
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "Ignoring invalid XEUS_SAS_HTML_WORKERS: " << workers_env << std::endl;
+            }
+        }
+        return 2;
+    }
+
+    html_pipeline::html_pipeline(size_t workers, std::function<void()> on_ready)
+        : m_on_ready(std::move(on_ready))
+        , m_stopping(false)
+    {
+        for (size_t i = 0; i < workers; ++i)
+        {
+            m_workers.emplace_back(&html_pipeline::worker_loop, this);
+        }
+    }
+
+    html_pipeline::~html_pipeline()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work_available.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    void html_pipeline::push(std::string block, cleaner clean)
+    {
+        if (m_workers.empty())
+        {
+            std::string html = clean_or_raw(clean, block);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots.push_back(slot{std::move(html), clean, true});
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots.push_back(slot{std::move(block), clean, false});
+            m_jobs.push_back(&m_slots.back());
+        }
+        m_work_available.notify_one();
+    }
+
+    bool html_pipeline::pop(std::string& html)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_slots.empty() || !m_slots.front().ready)
+        {
+            return false;
+        }
+        html = std::move(m_slots.front().text);
+        m_slots.pop_front();
+        return true;
+    }
+
+    bool html_pipeline::wait_pop(std::string& html)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_block_ready.wait(lock, [this] { return m_slots.empty() || m_slots.front().ready; });
+        if (m_slots.empty())
+        {
+            return false;
+        }
+        html = std::move(m_slots.front().text);
+        m_slots.pop_front();
+        return true;
+    }
+
+    bool html_pipeline::pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_slots.empty();
+    }
+
+    void html_pipeline::worker_loop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_work_available.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping)
+            {
+                return;
+            }
+            slot* job = m_jobs.front();
+            m_jobs.pop_front();
+
+            // Nobody else touches a slot until it is marked ready
+            lock.unlock();
+            std::string html = clean_or_raw(job->clean, job->text);
+            lock.lock();
+
+            job->text = std::move(html);
+            job->ready = true;
+            m_block_ready.notify_all();
+            if (m_on_ready)
+            {
+                lock.unlock();
+                m_on_ready();
+                lock.lock();
+            }
+        }
+    }
+
+} // namespace xeus_sas
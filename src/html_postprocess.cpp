@@ -0,0 +1,589 @@
+#include "xeus-sas/html_postprocess.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace xeus_sas
+{
+    namespace
+    {
+        bool is_space(char c)
+        {
+            return std::isspace(static_cast<unsigned char>(c)) != 0;
+        }
+
+        /**
+         * Forward-only rewriter for the markup-level clean-up of ODS HTML5.
+         *
+         * Every byte of the input is looked at a bounded number of times and
+         * output is appended to a buffer sized up front, so the cost is
+         * linear in the block size. Rules, applied as tags go by:
+         * - consecutive colgroups of a table are merged into one
+         * - the systitleandfootercontainer div is dropped
+         * - style and aria-label attributes are dropped from tags
+         * - thead rows are held back and emitted right after <tbody>
+         * - captions with only whitespace inside are dropped
+         */
+        class ods_markup_rewriter
+        {
+        public:
+            explicit ods_markup_rewriter(const std::string& html)
+                : m_in(html)
+                , m_sink(&m_out)
+                , m_thead_pending(false)
+            {
+                m_out.reserve(html.size());
+            }
+
+            std::string run()
+            {
+                const size_t size = m_in.size();
+                size_t pos = 0;
+                while (pos < size)
+                {
+                    size_t open = m_in.find('<', pos);
+                    if (open == std::string::npos)
+                    {
+                        emit(pos, size);
+                        break;
+                    }
+                    emit(pos, open);
+                    pos = rewrite_tag(open);
+                }
+                flush_thead();
+
+                if (m_merged_colgroups > 0 || m_moved_theads > 0 || m_removed_captions > 0)
+                {
+                    std::cerr << "Simplified ODS markup: merged " << m_merged_colgroups << " colgroups, moved "
+                              << m_moved_theads << " thead sections, removed " << m_removed_captions
+                              << " empty captions" << std::endl;
+                }
+                return std::move(m_out);
+            }
+
+        private:
+            void emit(size_t from, size_t to)
+            {
+                m_sink->append(m_in, from, to - from);
+            }
+
+            // Whether a tag named @p name starts at @p pos ("<name" followed
+            // by whitespace, '>' or '/')
+            bool tag_at(size_t pos, const char* name) const
+            {
+                size_t length = std::char_traits<char>::length(name);
+                if (m_in[pos] != '<' || m_in.compare(pos + 1, length, name) != 0)
+                {
+                    return false;
+                }
+                size_t after = pos + 1 + length;
+                return after < m_in.size() && (m_in[after] == '>' || m_in[after] == '/' || is_space(m_in[after]));
+            }
+
+            // Position just past the '>' closing the tag at @p open; quoted
+            // attribute values may contain '>'
+            size_t tag_end(size_t open) const
+            {
+                char quote = 0;
+                for (size_t i = open + 1; i < m_in.size(); ++i)
+                {
+                    char c = m_in[i];
+                    if (quote)
+                    {
+                        if (c == quote)
+                        {
+                            quote = 0;
+                        }
+                    }
+                    else if (c == '"' || c == '\'')
+                    {
+                        quote = c;
+                    }
+                    else if (c == '>')
+                    {
+                        return i + 1;
+                    }
+                }
+                return std::string::npos;
+            }
+
+            size_t rewrite_tag(size_t open)
+            {
+                if (m_in.compare(open, 4, "<!--") == 0)
+                {
+                    size_t close = m_in.find("-->", open + 4);
+                    size_t end = close == std::string::npos ? m_in.size() : close + 3;
+                    emit(open, end);
+                    return end;
+                }
+
+                size_t end = tag_end(open);
+                if (end == std::string::npos)
+                {
+                    emit(open, m_in.size());
+                    return m_in.size();
+                }
+
+                if (m_in.compare(open, 7, "<thead>") == 0)
+                {
+                    flush_thead();
+                    m_thead.clear();
+                    m_sink = &m_thead;
+                    return end;
+                }
+                if (m_in.compare(open, 8, "</thead>") == 0 && m_sink == &m_thead)
+                {
+                    m_sink = &m_out;
+                    m_thead_pending = true;
+                    return end;
+                }
+                if (m_in.compare(open, 7, "<tbody>") == 0)
+                {
+                    emit(open, end);
+                    if (m_thead_pending && m_sink == &m_out)
+                    {
+                        m_out += m_thead;
+                        m_thead_pending = false;
+                        ++m_moved_theads;
+                    }
+                    return end;
+                }
+                if (m_in.compare(open, 8, "</table>") == 0)
+                {
+                    flush_thead();
+                    emit(open, end);
+                    return end;
+                }
+                if (tag_at(open, "div"))
+                {
+                    std::string_view tag(m_in.data() + open, end - open);
+                    size_t close = std::string::npos;
+                    if (tag.find("systitleandfootercontainer") != std::string_view::npos &&
+                        (close = m_in.find("</div>", end)) != std::string::npos)
+                    {
+                        return close + 6;
+                    }
+                }
+                if (tag_at(open, "caption"))
+                {
+                    size_t close = m_in.find("</caption>", end);
+                    if (close != std::string::npos &&
+                        std::all_of(m_in.begin() + end, m_in.begin() + close, is_space))
+                    {
+                        ++m_removed_captions;
+                        return close + 10;
+                    }
+                }
+                if (tag_at(open, "colgroup"))
+                {
+                    size_t merged_end = merge_colgroups(open);
+                    if (merged_end != std::string::npos)
+                    {
+                        return merged_end;
+                    }
+                }
+
+                copy_tag(open, end);
+                return end;
+            }
+
+            // Replace a run of colgroups (whitespace between them included)
+            // by one with all their columns; npos if there is only one
+            size_t merge_colgroups(size_t open)
+            {
+                size_t groups = 0;
+                size_t columns = 0;
+                size_t after = open;
+                size_t scan = open;
+                while (scan < m_in.size() && tag_at(scan, "colgroup"))
+                {
+                    size_t close = m_in.find("</colgroup>", scan);
+                    if (close == std::string::npos)
+                    {
+                        break;
+                    }
+                    for (size_t col = m_in.find("<col/>", scan); col < close; col = m_in.find("<col/>", col + 6))
+                    {
+                        ++columns;
+                    }
+                    ++groups;
+                    after = close + 11;
+                    scan = after;
+                    while (scan < m_in.size() && is_space(m_in[scan]))
+                    {
+                        ++scan;
+                    }
+                }
+
+                if (groups < 2)
+                {
+                    return std::string::npos;
+                }
+                *m_sink += "<colgroup>";
+                for (size_t i = 0; i < columns; ++i)
+                {
+                    *m_sink += "<col/>";
+                }
+                *m_sink += "</colgroup>";
+                m_merged_colgroups += groups;
+                return after;
+            }
+
+            // Copy a tag without its style and aria-label attributes (and
+            // the whitespace before them)
+            void copy_tag(size_t open, size_t end)
+            {
+                // Most tags have neither attribute
+                std::string_view tag(m_in.data() + open, end - open);
+                if (tag.find("style") == std::string_view::npos && tag.find("aria-label") == std::string_view::npos)
+                {
+                    emit(open, end);
+                    return;
+                }
+
+                size_t pos = open + 1;
+                while (pos < end && !is_space(m_in[pos]) && m_in[pos] != '>' && m_in[pos] != '/')
+                {
+                    ++pos;
+                }
+                if (pos == open + 1 && m_in[pos] == '/')
+                {
+                    // Closing tag: nothing to strip
+                    emit(open, end);
+                    return;
+                }
+                emit(open, pos);
+
+                while (pos < end)
+                {
+                    size_t attribute_start = pos;
+                    while (pos < end && is_space(m_in[pos]))
+                    {
+                        ++pos;
+                    }
+                    if (pos >= end || m_in[pos] == '>' || m_in[pos] == '/')
+                    {
+                        emit(attribute_start, end);
+                        return;
+                    }
+
+                    size_t name_start = pos;
+                    while (pos < end && m_in[pos] != '=' && m_in[pos] != '>' && m_in[pos] != '/' &&
+                           !is_space(m_in[pos]))
+                    {
+                        ++pos;
+                    }
+                    size_t name_end = pos;
+                    if (pos < end && m_in[pos] == '=')
+                    {
+                        ++pos;
+                        if (pos < end && (m_in[pos] == '"' || m_in[pos] == '\''))
+                        {
+                            size_t close = m_in.find(m_in[pos], pos + 1);
+                            pos = close == std::string::npos || close >= end ? end - 1 : close + 1;
+                        }
+                        else
+                        {
+                            while (pos < end && !is_space(m_in[pos]) && m_in[pos] != '>')
+                            {
+                                ++pos;
+                            }
+                        }
+                    }
+
+                    if (pos == name_start)
+                    {
+                        // Stray character; keep it and move on
+                        ++pos;
+                    }
+                    size_t name_length = name_end - name_start;
+                    bool dropped = (name_length == 5 && m_in.compare(name_start, 5, "style") == 0) ||
+                                   (name_length == 10 && m_in.compare(name_start, 10, "aria-label") == 0);
+                    if (!dropped)
+                    {
+                        emit(attribute_start, pos);
+                    }
+                }
+            }
+
+            // A thead without a following tbody stays where it was
+            void flush_thead()
+            {
+                if (m_sink == &m_thead || m_thead_pending)
+                {
+                    m_sink = &m_out;
+                    m_out += "<thead>";
+                    m_out += m_thead;
+                    if (m_thead_pending)
+                    {
+                        m_out += "</thead>";
+                    }
+                    m_thead.clear();
+                    m_thead_pending = false;
+                }
+            }
+
+            const std::string& m_in;
+            std::string m_out;
+            std::string m_thead;            // Rows of the last thead, until its tbody
+            std::string* m_sink;            // m_out, or m_thead inside a thead
+            bool m_thead_pending;           // m_thead is complete and waits for <tbody>
+            size_t m_merged_colgroups = 0;
+            size_t m_moved_theads = 0;
+            size_t m_removed_captions = 0;
+        };
+
+        /**
+         * Rebuilds every table of a block as a plain grid without spans.
+         *
+         * A cell spanning several columns is repeated in each of them; a
+         * cell spanning several rows appears in its last row, with empty
+         * cells above it. Cells are string_views into the source (minus
+         * their rowspan/colspan attributes) and the grid is a flat
+         * row-major array of cell indices. All buffers are reused from table
+         * to table, so a block with hundreds of BY-group tables costs a
+         * bounded number of allocations.
+         */
+        class table_normalizer
+        {
+        public:
+            explicit table_normalizer(const std::string& html)
+                : m_in(html)
+            {
+                m_out.reserve(html.size());
+            }
+
+            std::string run()
+            {
+                size_t pos = 0;
+                size_t tables = 0;
+                while (true)
+                {
+                    size_t table_start = m_in.find("<table", pos);
+                    size_t table_end = table_start == std::string::npos ? table_start
+                                                                        : m_in.find("</table>", table_start);
+                    if (table_end == std::string::npos)
+                    {
+                        m_out.append(m_in, pos, std::string::npos);
+                        break;
+                    }
+                    m_out.append(m_in, pos, table_start - pos);
+                    normalize(table_start, table_end);
+                    pos = table_end + 8;
+                    ++tables;
+                }
+
+                if (tables > 0)
+                {
+                    std::cerr << "Flattened " << tables << " table(s) (removed rowspan/colspan)" << std::endl;
+                }
+                return std::move(m_out);
+            }
+
+        private:
+            static constexpr int32_t no_cell = -1;
+            static constexpr int32_t filler_cell = -2;    // Row of a rowspan above its content
+
+            struct cell
+            {
+                std::string_view parts[3];              // Markup without the span attributes
+                size_t row;
+                size_t column;
+                size_t rowspan;
+                size_t colspan;
+            };
+
+            // Value of a span attribute ("rowspan=\"" or "colspan=\"") in
+            // [begin, end), and the range to cut from the markup: the
+            // attribute and the space before it. 1 if absent.
+            size_t span_attribute(const char* prefix, size_t begin, size_t end,
+                                  size_t& cut_begin, size_t& cut_end) const
+            {
+                // Search the cell only, not the rest of the block
+                std::string_view markup(m_in.data() + begin, end - begin);
+                size_t found = markup.find(prefix);
+                if (found == std::string_view::npos)
+                {
+                    return 1;
+                }
+                found += begin;
+                size_t value_end = m_in.find('"', found + 9);
+                if (value_end == std::string::npos || value_end >= end)
+                {
+                    return 1;
+                }
+
+                size_t value = 0;
+                for (size_t i = found + 9; i < value_end && value < 100000; ++i)
+                {
+                    if (m_in[i] < '0' || m_in[i] > '9')
+                    {
+                        return 1;
+                    }
+                    value = value * 10 + static_cast<size_t>(m_in[i] - '0');
+                }
+                cut_begin = found > begin && m_in[found - 1] == ' ' ? found - 1 : found;
+                cut_end = value_end + 1;
+                return std::max<size_t>(1, value);
+            }
+
+            void add_cell(size_t begin, size_t end, size_t row, size_t& column)
+            {
+                cell c;
+                size_t cuts[2][2] = {{end, end}, {end, end}};
+                c.rowspan = span_attribute("rowspan=\"", begin, end, cuts[0][0], cuts[0][1]);
+                c.colspan = span_attribute("colspan=\"", begin, end, cuts[1][0], cuts[1][1]);
+                if (cuts[1][0] < cuts[0][0])
+                {
+                    std::swap(cuts[0], cuts[1]);
+                }
+                c.parts[0] = std::string_view(m_in.data() + begin, cuts[0][0] - begin);
+                c.parts[1] = std::string_view(m_in.data() + cuts[0][1], cuts[1][0] - cuts[0][1]);
+                c.parts[2] = std::string_view(m_in.data() + cuts[1][1], end - cuts[1][1]);
+
+                // Next column not covered by a rowspan from above
+                while (column < m_busy_until.size() && m_busy_until[column] > row)
+                {
+                    ++column;
+                }
+                c.row = row;
+                c.column = column;
+                if (m_busy_until.size() < column + c.colspan)
+                {
+                    m_busy_until.resize(column + c.colspan, 0);
+                }
+                for (size_t k = column; k < column + c.colspan; ++k)
+                {
+                    m_busy_until[k] = std::max(m_busy_until[k], row + c.rowspan);
+                }
+                m_rows = std::max(m_rows, row + c.rowspan);
+                column += c.colspan;
+                m_cells.push_back(c);
+            }
+
+            void parse_row(size_t begin, size_t end, size_t row)
+            {
+                size_t column = 0;
+                size_t pos = begin;
+                while (true)
+                {
+                    size_t open = m_in.find('<', pos);
+                    while (open != std::string::npos && open < end &&
+                           !(m_in.compare(open, 3, "<th") == 0 || m_in.compare(open, 3, "<td") == 0))
+                    {
+                        open = m_in.find('<', open + 1);
+                    }
+                    if (open == std::string::npos || open >= end)
+                    {
+                        return;
+                    }
+
+                    const char* close_tag = m_in[open + 2] == 'h' ? "</th>" : "</td>";
+                    size_t close = m_in.find(close_tag, open);
+                    if (close == std::string::npos || close + 5 > end)
+                    {
+                        return;
+                    }
+                    add_cell(open, close + 5, row, column);
+                    pos = close + 5;
+                }
+            }
+
+            void append_cell(const cell& c)
+            {
+                for (const auto& part : c.parts)
+                {
+                    m_out.append(part.data(), part.size());
+                }
+            }
+
+            void normalize(size_t table_start, size_t table_end)
+            {
+                m_cells.clear();
+                m_busy_until.clear();
+                m_rows = 0;
+
+                size_t row = 0;
+                size_t pos = table_start;
+                while (true)
+                {
+                    size_t row_start = m_in.find("<tr", pos);
+                    if (row_start == std::string::npos || row_start >= table_end)
+                    {
+                        break;
+                    }
+                    size_t row_end = m_in.find("</tr>", row_start);
+                    if (row_end == std::string::npos || row_end >= table_end)
+                    {
+                        break;
+                    }
+                    parse_row(row_start, row_end, row);
+                    m_rows = std::max(m_rows, row + 1);
+                    ++row;
+                    pos = row_end + 5;
+                }
+
+                // Lay the cells out; later cells win where spans overlap
+                size_t width = m_busy_until.size();
+                m_grid.assign(m_rows * width, no_cell);
+                for (size_t i = 0; i < m_cells.size(); ++i)
+                {
+                    const cell& c = m_cells[i];
+                    for (size_t r = c.row; r < c.row + c.rowspan; ++r)
+                    {
+                        int32_t value = r + 1 < c.row + c.rowspan ? filler_cell : static_cast<int32_t>(i);
+                        std::fill_n(m_grid.begin() + r * width + c.column, c.colspan, value);
+                    }
+                }
+
+                m_out += "<table class=\"table\"><tbody>";
+                for (size_t r = 0; r < m_rows; ++r)
+                {
+                    m_out += "<tr>";
+                    for (size_t k = r * width; k < (r + 1) * width; ++k)
+                    {
+                        if (m_grid[k] == filler_cell)
+                        {
+                            m_out += "<td>&#160;</td>";
+                        }
+                        else if (m_grid[k] != no_cell)
+                        {
+                            append_cell(m_cells[static_cast<size_t>(m_grid[k])]);
+                        }
+                    }
+                    m_out += "</tr>";
+                }
+                m_out += "</tbody></table>";
+            }
+
+            const std::string& m_in;
+            std::string m_out;
+            std::vector<cell> m_cells;              // Cells of the current table
+            std::vector<size_t> m_busy_until;       // Per column: first row not covered by a rowspan
+            std::vector<int32_t> m_grid;            // m_rows x columns cell indices
+            size_t m_rows = 0;
+        };
+    }
+
+    std::string clean_ods_html(const std::string& html)
+    {
+        // Markup clean-up, then every table rebuilt without rowspan/colspan:
+        // terminal renderers like euporie cannot lay out spanning cells
+        return table_normalizer(ods_markup_rewriter(html).run()).run();
+    }
+
+    std::string normalize_compact_html(const std::string& html)
+    {
+        // Everything but spans is already in shape; most tables have none
+        if (html.find("span=\"") == std::string::npos)
+        {
+            return html;
+        }
+        return table_normalizer(html).run();
+    }
+
+} // namespace xeus_sas
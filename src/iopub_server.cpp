@@ -0,0 +1,124 @@
+#include "xeus-sas/iopub_server.hpp"
+
+#include "xeus-zmq/xserver_zmq.hpp"
+
+#include <utility>
+
+namespace xeus_sas
+{
+    namespace
+    {
+        thread_local const nl::json* t_publish_parent = nullptr;
+    }
+
+    // publish_parent_scope
+
+    publish_parent_scope::publish_parent_scope(const nl::json& parent)
+        : m_previous(t_publish_parent)
+    {
+        t_publish_parent = &parent;
+    }
+
+    publish_parent_scope::~publish_parent_scope()
+    {
+        t_publish_parent = m_previous;
+    }
+
+    const nl::json* publish_parent_scope::current()
+    {
+        return t_publish_parent;
+    }
+
+    // iopub_server
+
+    iopub_server::iopub_server(std::unique_ptr<xeus::xserver> server)
+        : m_server(std::move(server))
+    {
+        // The kernel registers its listeners on this server; messages the
+        // wrapped one receives are passed on to them
+        m_server->register_shell_listener([this](xeus::xmessage message)
+        {
+            notify_shell_listener(std::move(message));
+        });
+        m_server->register_control_listener([this](xeus::xmessage message)
+        {
+            notify_control_listener(std::move(message));
+        });
+        m_server->register_stdin_listener([this](xeus::xmessage message)
+        {
+            notify_stdin_listener(std::move(message));
+        });
+        m_server->register_internal_listener([this](nl::json message)
+        {
+            return notify_internal_listener(std::move(message));
+        });
+    }
+
+    xeus::xcontrol_messenger& iopub_server::get_control_messenger_impl()
+    {
+        return m_server->get_control_messenger();
+    }
+
+    void iopub_server::send_shell_impl(xeus::xmessage message)
+    {
+        m_server->send_shell(std::move(message));
+    }
+
+    void iopub_server::send_control_impl(xeus::xmessage message)
+    {
+        m_server->send_control(std::move(message));
+    }
+
+    void iopub_server::send_stdin_impl(xeus::xmessage message)
+    {
+        m_server->send_stdin(std::move(message));
+    }
+
+    void iopub_server::publish_impl(xeus::xpub_message message, xeus::channel c)
+    {
+        const nl::json* parent = publish_parent_scope::current();
+        std::lock_guard<std::mutex> lock(m_publish_mutex);
+        if (parent)
+        {
+            m_server->publish(xeus::xpub_message(message.topic(),
+                                                 message.header(),
+                                                 *parent,
+                                                 message.metadata(),
+                                                 message.content(),
+                                                 message.buffers()),
+                              c);
+        }
+        else
+        {
+            m_server->publish(std::move(message), c);
+        }
+    }
+
+    void iopub_server::start_impl(xeus::xpub_message message)
+    {
+        m_server->start(std::move(message));
+    }
+
+    void iopub_server::abort_queue_impl(const listener& l, long polling_interval)
+    {
+        m_server->abort_queue(l, polling_interval);
+    }
+
+    void iopub_server::stop_impl()
+    {
+        m_server->stop();
+    }
+
+    void iopub_server::update_config_impl(xeus::xconfiguration& config) const
+    {
+        m_server->update_config(config);
+    }
+
+    std::unique_ptr<xeus::xserver> make_iopub_server(xeus::xcontext& context,
+                                                     const xeus::xconfiguration& config,
+                                                     nl::json::error_handler_t eh)
+    {
+        return std::make_unique<iopub_server>(xeus::make_xserver_default(context, config, eh));
+    }
+
+} // namespace xeus_sas
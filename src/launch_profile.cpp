@@ -0,0 +1,489 @@
+#include "xeus-sas/launch_profile.hpp"
+#include "xeus-sas/xeus_sas_config.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "nlohmann/json.hpp"
+
+namespace nl = nlohmann;
+
+namespace xeus_sas
+{
+    namespace
+    {
+        // Anything from here up is v1's way of saying "no limit"
+        const unsigned long long unlimited_memory = 1ULL << 60;
+
+        // Profile values that map to one SAS option each
+        struct profile_field
+        {
+            const char* key;
+            std::string launch_profile::* value;
+        };
+
+        const profile_field profile_fields[] = {
+            {"memsize", &launch_profile::memsize},
+            {"sortsize", &launch_profile::sortsize},
+            {"cpucount", &launch_profile::cpucount},
+            {"threads", &launch_profile::threads},
+            {"bufsize", &launch_profile::bufsize},
+            {"work", &launch_profile::work},
+        };
+
+        std::string read_first_line(const std::string& path)
+        {
+            std::ifstream file(path);
+            std::string line;
+            std::getline(file, line);
+            return line;
+        }
+
+        bool is_directory(const std::string& path)
+        {
+            struct stat info;
+            return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+        }
+
+        // The cgroup directory and its ancestors up to the mount point. If
+        // the cgroup is not visible (a container sees the host's path), only
+        // the mount point, which is then the container's own cgroup.
+        std::vector<std::string> cgroup_directories(const std::string& mount, std::string path)
+        {
+            std::vector<std::string> directories;
+            if (path.empty() || !is_directory(mount + path))
+            {
+                path = "/";
+            }
+            while (!path.empty() && path != "/")
+            {
+                directories.push_back(mount + path);
+                path.erase(path.find_last_of('/'));
+            }
+            directories.push_back(mount);
+            return directories;
+        }
+
+        void tighten_cpus(cgroup_limits& limits, double cpus)
+        {
+            if (cpus > 0.0 && (limits.cpus == 0.0 || cpus < limits.cpus))
+            {
+                limits.cpus = cpus;
+            }
+        }
+
+        void tighten_memory(cgroup_limits& limits, unsigned long long bytes)
+        {
+            if (bytes > 0 && (limits.memory_bytes == 0 || bytes < limits.memory_bytes))
+            {
+                limits.memory_bytes = bytes;
+            }
+        }
+
+        bool has_controller(const std::string& controllers, const std::string& name)
+        {
+            std::stringstream list(controllers);
+            std::string controller;
+            while (std::getline(list, controller, ','))
+            {
+                if (controller == name)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::string profile_value(const nl::json& value, const std::string& key)
+        {
+            if (value.is_string())
+            {
+                return value.get<std::string>();
+            }
+            if (value.is_number())
+            {
+                return value.dump();
+            }
+            throw std::runtime_error("\"" + key + "\" must be a string or a number");
+        }
+
+        bool is_threads_value(const std::string& value)
+        {
+            return value.empty() || value == "yes" || value == "no";
+        }
+
+        void set_from_environment(const char* name, std::string& value)
+        {
+            const char* env = std::getenv(name);
+            if (env && *env)
+            {
+                value = env;
+            }
+        }
+    }
+
+    bool parse_cpu_max(const std::string& content, double& cpus)
+    {
+        std::istringstream fields(content);
+        std::string quota;
+        double period = 0.0;
+        if (!(fields >> quota >> period) || quota == "max" || period <= 0.0)
+        {
+            return false;
+        }
+        try
+        {
+            cpus = std::stod(quota) / period;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+        return cpus > 0.0;
+    }
+
+    bool parse_cfs_quota(const std::string& quota, const std::string& period, double& cpus)
+    {
+        try
+        {
+            double quota_us = std::stod(quota);
+            double period_us = std::stod(period);
+            if (quota_us <= 0.0 || period_us <= 0.0)
+            {
+                return false;
+            }
+            cpus = quota_us / period_us;
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    bool parse_memory_limit(const std::string& content, unsigned long long& bytes)
+    {
+        if (content.empty() || content.compare(0, 3, "max") == 0)
+        {
+            return false;
+        }
+        try
+        {
+            unsigned long long value = std::stoull(content);
+            if (value == 0 || value >= unlimited_memory)
+            {
+                return false;
+            }
+            bytes = value;
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    cgroup_limits read_cgroup_limits(const std::string& proc_cgroup, const std::string& cgroup_root)
+    {
+        cgroup_limits limits;
+        std::ifstream file(proc_cgroup);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            // hierarchy-ID:controller-list:cgroup-path
+            size_t first = line.find(':');
+            size_t second = first == std::string::npos ? first : line.find(':', first + 1);
+            if (second == std::string::npos)
+            {
+                continue;
+            }
+            std::string hierarchy = line.substr(0, first);
+            std::string controllers = line.substr(first + 1, second - first - 1);
+            std::string path = line.substr(second + 1);
+
+            if (hierarchy == "0" && controllers.empty())
+            {
+                // v2; in hybrid setups the unified tree has no controllers
+                // and these files simply do not exist
+                for (const auto& directory : cgroup_directories(cgroup_root, path))
+                {
+                    double cpus = 0.0;
+                    if (parse_cpu_max(read_first_line(directory + "/cpu.max"), cpus))
+                    {
+                        tighten_cpus(limits, cpus);
+                    }
+                    unsigned long long bytes = 0;
+                    if (parse_memory_limit(read_first_line(directory + "/memory.max"), bytes))
+                    {
+                        tighten_memory(limits, bytes);
+                    }
+                }
+                continue;
+            }
+
+            if (has_controller(controllers, "cpu"))
+            {
+                for (const char* mount : {"/cpu,cpuacct", "/cpu"})
+                {
+                    if (!is_directory(cgroup_root + mount))
+                    {
+                        continue;
+                    }
+                    for (const auto& directory : cgroup_directories(cgroup_root + mount, path))
+                    {
+                        double cpus = 0.0;
+                        if (parse_cfs_quota(read_first_line(directory + "/cpu.cfs_quota_us"),
+                                            read_first_line(directory + "/cpu.cfs_period_us"), cpus))
+                        {
+                            tighten_cpus(limits, cpus);
+                        }
+                    }
+                    break;
+                }
+            }
+            if (has_controller(controllers, "memory"))
+            {
+                for (const auto& directory : cgroup_directories(cgroup_root + "/memory", path))
+                {
+                    unsigned long long bytes = 0;
+                    if (parse_memory_limit(read_first_line(directory + "/memory.limit_in_bytes"), bytes))
+                    {
+                        tighten_memory(limits, bytes);
+                    }
+                }
+            }
+        }
+        return limits;
+    }
+
+    unsigned available_cpus()
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            return static_cast<unsigned>(std::max(1, CPU_COUNT(&set)));
+        }
+#endif
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        return online > 0 ? static_cast<unsigned>(online) : 1;
+    }
+
+    launch_profile derive_launch_profile(const cgroup_limits& limits, unsigned cpus)
+    {
+        launch_profile profile;
+
+        // SAS sizes its thread pools from the host's CPU count, which in a
+        // container is far more than the quota lets it use
+        unsigned count = std::max(1u, cpus);
+        if (limits.cpus > 0.0)
+        {
+            count = std::min(count, std::max(1u, static_cast<unsigned>(std::ceil(limits.cpus))));
+        }
+        profile.cpucount = std::to_string(count);
+        profile.threads = count > 1 ? "yes" : "no";
+
+        // MEMSIZE is left to the profile: the active process, the standby
+        // pool and every named session share the memory limit, and there is
+        // no bound on how many of them a kernel runs
+        return profile;
+    }
+
+    launch_profile load_launch_profile(const std::string& path)
+    {
+        launch_profile profile;
+        std::ifstream file(path);
+        if (!file)
+        {
+            return profile;
+        }
+
+        nl::json json;
+        try
+        {
+            file >> json;
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error("Invalid launch profile " + path + ": " + e.what());
+        }
+        if (!json.is_object())
+        {
+            throw std::runtime_error("Invalid launch profile " + path + ": not a JSON object");
+        }
+
+        try
+        {
+            for (auto it = json.begin(); it != json.end(); ++it)
+            {
+                const std::string& key = it.key();
+                if (key == "auto")
+                {
+                    if (!it->is_boolean())
+                    {
+                        throw std::runtime_error("\"auto\" must be true or false");
+                    }
+                    profile.auto_tune = it->get<bool>();
+                }
+                else if (key == "options")
+                {
+                    if (!it->is_array())
+                    {
+                        throw std::runtime_error("\"options\" must be an array of strings");
+                    }
+                    for (const auto& option : *it)
+                    {
+                        profile.options.push_back(profile_value(option, key));
+                    }
+                }
+                else
+                {
+                    auto field = std::find_if(std::begin(profile_fields), std::end(profile_fields),
+                                              [&key](const profile_field& f) { return key == f.key; });
+                    if (field == std::end(profile_fields))
+                    {
+                        throw std::runtime_error("unknown key \"" + key + "\"");
+                    }
+                    profile.*(field->value) = profile_value(*it, key);
+                }
+            }
+            if (!is_threads_value(profile.threads))
+            {
+                throw std::runtime_error("\"threads\" must be \"yes\" or \"no\"");
+            }
+        }
+        catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error("Invalid launch profile " + path + ": " + e.what());
+        }
+        return profile;
+    }
+
+    void apply_launch_environment(launch_profile& profile)
+    {
+        set_from_environment("XEUS_SAS_MEMSIZE", profile.memsize);
+        set_from_environment("XEUS_SAS_SORTSIZE", profile.sortsize);
+        set_from_environment("XEUS_SAS_CPUCOUNT", profile.cpucount);
+        std::string threads = profile.threads;
+        set_from_environment("XEUS_SAS_THREADS", threads);
+        if (is_threads_value(threads))
+        {
+            profile.threads = threads;
+        }
+        else
+        {
+            std::cerr << "Ignoring invalid XEUS_SAS_THREADS (expected yes or no): " << threads << std::endl;
+        }
+        set_from_environment("XEUS_SAS_BUFSIZE", profile.bufsize);
+        set_from_environment("XEUS_SAS_WORK", profile.work);
+
+        const char* options_env = std::getenv("XEUS_SAS_OPTIONS");
+        if (options_env)
+        {
+            std::istringstream options(options_env);
+            std::string option;
+            while (options >> option)
+            {
+                profile.options.push_back(option);
+            }
+        }
+
+        const char* auto_env = std::getenv("XEUS_SAS_AUTO_TUNE");
+        if (auto_env && *auto_env)
+        {
+            profile.auto_tune = std::string(auto_env) != "0";
+        }
+    }
+
+    void fill_launch_profile(launch_profile& profile, const launch_profile& derived)
+    {
+        for (const auto& field : profile_fields)
+        {
+            if ((profile.*(field.value)).empty())
+            {
+                profile.*(field.value) = derived.*(field.value);
+            }
+        }
+    }
+
+    launch_profile resolve_launch_profile()
+    {
+        std::string path;
+        const char* path_env = std::getenv("XEUS_SAS_LAUNCH_PROFILE");
+        if (path_env && *path_env)
+        {
+            path = path_env;
+        }
+        else if (*kernelspec_dir)
+        {
+            path = std::string(kernelspec_dir) + "/launch_profile.json";
+        }
+
+        launch_profile profile;
+        if (!path.empty())
+        {
+            try
+            {
+                profile = load_launch_profile(path);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Ignoring launch profile: " << e.what() << std::endl;
+            }
+        }
+        apply_launch_environment(profile);
+
+        if (profile.auto_tune)
+        {
+            cgroup_limits limits = read_cgroup_limits();
+            unsigned cpus = available_cpus();
+            std::cerr << "Container limits: "
+                      << (limits.cpus > 0.0 ? std::to_string(limits.cpus) + " CPUs" : "no CPU quota") << ", "
+                      << (limits.memory_bytes > 0 ? std::to_string(limits.memory_bytes / (1024 * 1024)) + " MB"
+                                                  : "no memory limit")
+                      << ", " << cpus << " CPUs by affinity" << std::endl;
+            fill_launch_profile(profile, derive_launch_profile(limits, cpus));
+        }
+        return profile;
+    }
+
+    std::vector<std::string> launch_options(const launch_profile& profile)
+    {
+        std::vector<std::string> options;
+        auto add = [&options](const char* name, const std::string& value)
+        {
+            if (!value.empty())
+            {
+                options.push_back(name);
+                options.push_back(value);
+            }
+        };
+        add("-memsize", profile.memsize);
+        add("-sortsize", profile.sortsize);
+        add("-cpucount", profile.cpucount);
+        add("-bufsize", profile.bufsize);
+        add("-work", profile.work);
+        if (profile.threads == "yes")
+        {
+            options.push_back("-threads");
+        }
+        else if (profile.threads == "no")
+        {
+            options.push_back("-nothreads");
+        }
+        options.insert(options.end(), profile.options.begin(), profile.options.end());
+        return options;
+    }
+
+} // namespace xeus_sas
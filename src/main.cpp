@@ -4,6 +4,7 @@
 #include <csignal>
 #include <atomic>
 #include <unistd.h>
+#include <fcntl.h>
 
 #include "xeus/xkernel.hpp"
 #include "xeus/xkernel_configuration.hpp"
@@ -11,11 +12,16 @@
 #include "xeus-zmq/xzmq_context.hpp"
 
 #include "xeus-sas/xinterpreter.hpp"
+#include "xeus-sas/iopub_server.hpp"
 #include "xeus-sas/xeus_sas_config.hpp"
 
 // Global flag to indicate interrupt was requested
 std::atomic<bool> g_interrupt_requested{false};
 
+// Self-pipe written by the SIGINT handler; the interpreter watches the read end
+static int g_interrupt_pipe[2] = {-1, -1};
+int g_interrupt_fd = -1;
+
 // Global pointer to interpreter for signal handler access
 xeus_sas::interpreter* g_interpreter = nullptr;
 
@@ -24,8 +30,9 @@ xeus_sas::interpreter* g_interpreter = nullptr;
  *
  * When SIGINT is received (Ctrl-C or kernel interrupt), this handler:
  * 1. Prevents the signal from propagating to the child SAS process
- * 2. Restarts the SAS session to recover gracefully
- * 3. Notifies the user that session state was lost
+ * 2. Wakes the interpreter, which aborts running cells and restarts the
+ *    SAS sessions to recover gracefully
+ * 3. The interpreter notifies the user that session state was lost
  *
  * This is necessary because SAS running in batch mode (-stdio) does not
  * support graceful interruption. Sending SIGINT to SAS would kill the
@@ -37,8 +44,15 @@ xeus_sas::interpreter* g_interpreter = nullptr;
  */
 void sigint_handler(int /* signal */)
 {
-    // Only set the interrupt flag - actual handling happens in main loop
+    // Only set the interrupt flag and poke the self-pipe - the interpreter's
+    // interrupt watcher does the actual work right away
     g_interrupt_requested.store(true, std::memory_order_release);
+    if (g_interrupt_pipe[1] >= 0)
+    {
+        const char token = 'i';
+        ssize_t ignored = write(g_interrupt_pipe[1], &token, 1);
+        (void)ignored;
+    }
 
     // Write a simple message to stderr (async-signal-safe)
     const char msg[] = "\n[xeus-sas] Interrupt received, will restart SAS session...\n";
@@ -69,6 +83,30 @@ int main(int argc, char* argv[])
     // Store raw pointer for signal handler access (before moving ownership)
     g_interpreter = interpreter_ptr.get();
 
+    // Create the interrupt self-pipe before the handler can fire. Both ends
+    // are non-blocking (a full pipe already means "interrupt pending") and
+    // close-on-exec so SAS does not inherit them.
+#ifdef __linux__
+    if (pipe2(g_interrupt_pipe, O_CLOEXEC | O_NONBLOCK) == 0)
+    {
+        g_interrupt_fd = g_interrupt_pipe[0];
+    }
+#else
+    if (pipe(g_interrupt_pipe) == 0)
+    {
+        for (int fd : g_interrupt_pipe)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        g_interrupt_fd = g_interrupt_pipe[0];
+    }
+#endif
+    else
+    {
+        std::cerr << "Warning: Failed to create interrupt pipe; interrupts apply at the next cell" << std::endl;
+    }
+
     // Install custom SIGINT handler
     // This prevents SIGINT from killing the child SAS process
     struct sigaction sa;
@@ -85,19 +123,24 @@ int main(int argc, char* argv[])
         std::cerr << "[xeus-sas] Custom SIGINT handler installed for graceful interrupt recovery" << std::endl;
     }
 
+    // Writes to a SAS process that has exited must fail with EPIPE instead
+    // of killing the kernel
+    signal(SIGPIPE, SIG_IGN);
+
     // Print startup message
     std::cout << "Starting xeus-sas kernel version "
               << xeus_sas::version << std::endl;
     std::cout << "SAS Jupyter Kernel" << std::endl;
     std::cout << "NOTE: Interrupting the kernel will restart the SAS session (session state will be lost)" << std::endl;
 
-    // Create kernel
+    // Create kernel. Its server owns iopub, so that output published by
+    // session workers reaches the cell it belongs to.
     xeus::xkernel kernel(
         config,
         xeus::get_user_name(),
         std::move(context),
         std::move(interpreter_ptr),
-        xeus::make_xserver_default
+        xeus_sas::make_iopub_server
     );
 
     // Start kernel
@@ -0,0 +1,322 @@
+#include "xeus-sas/process_watchdog.hpp"
+#include "xeus-sas/resource_usage.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <dirent.h>
+
+namespace xeus_sas
+{
+    namespace
+    {
+        // Process activity is sampled at most this often
+        const std::chrono::milliseconds sample_interval(1000);
+
+        // Stop descending after this many processes (a fork bomb in an X
+        // command must not make every sample slower)
+        const size_t max_sampled_processes = 256;
+
+        // Children of every thread of @p pid
+        std::vector<pid_t> read_children(pid_t pid)
+        {
+            std::vector<pid_t> children;
+            std::string task_dir = "/proc/" + std::to_string(pid) + "/task";
+            DIR* handle = opendir(task_dir.c_str());
+            if (!handle)
+            {
+                return children;
+            }
+            while (struct dirent* entry = readdir(handle))
+            {
+                if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+                {
+                    continue;
+                }
+                std::string content;
+                read_proc_file(pid, std::string("task/") + entry->d_name + "/children", content);
+                std::istringstream list(content);
+                pid_t child;
+                while (list >> child)
+                {
+                    children.push_back(child);
+                }
+            }
+            closedir(handle);
+            return children;
+        }
+    }
+
+    execution_limits execution_limits::merged(const execution_limits& overrides) const
+    {
+        execution_limits result = *this;
+        if (overrides.soft_deadline.count() > 0)
+            result.soft_deadline = overrides.soft_deadline;
+        if (overrides.hard_deadline.count() > 0)
+            result.hard_deadline = overrides.hard_deadline;
+        if (overrides.hang_timeout.count() > 0)
+            result.hang_timeout = overrides.hang_timeout;
+        return result;
+    }
+
+    std::chrono::milliseconds parse_duration(const std::string& text)
+    {
+        size_t digits = 0;
+        while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits])))
+        {
+            ++digits;
+        }
+        if (digits == 0 || digits + 1 < text.size())
+        {
+            throw std::invalid_argument("Invalid duration: " + text);
+        }
+
+        long long value = std::stoll(text.substr(0, digits));
+        char unit = (digits < text.size()) ? static_cast<char>(std::tolower(text[digits])) : 's';
+        switch (unit)
+        {
+            case 's': return std::chrono::seconds(value);
+            case 'm': return std::chrono::minutes(value);
+            case 'h': return std::chrono::hours(value);
+            default:
+                throw std::invalid_argument("Invalid duration: " + text);
+        }
+    }
+
+    bool parse_proc_stat_times(const std::string& stat,
+                               unsigned long long& user_ticks,
+                               unsigned long long& system_ticks)
+    {
+        // The command name (field 2) is in parentheses and may itself contain
+        // spaces or ')'; fields are counted from the last ')'
+        size_t comm_end = stat.rfind(')');
+        if (comm_end == std::string::npos)
+        {
+            return false;
+        }
+
+        // Fields after comm start at 3 (state); utime and stime are 14 and 15
+        std::istringstream fields(stat.substr(comm_end + 1));
+        std::string field;
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        for (int index = 3; index <= 15; ++index)
+        {
+            if (!(fields >> field))
+            {
+                return false;
+            }
+            try
+            {
+                if (index == 14)
+                    utime = std::stoull(field);
+                else if (index == 15)
+                    stime = std::stoull(field);
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+
+        user_ticks = utime;
+        system_ticks = stime;
+        return true;
+    }
+
+    bool parse_proc_stat_cpu(const std::string& stat, unsigned long long& ticks)
+    {
+        unsigned long long user_ticks = 0;
+        unsigned long long system_ticks = 0;
+        if (!parse_proc_stat_times(stat, user_ticks, system_ticks))
+        {
+            return false;
+        }
+        ticks = user_ticks + system_ticks;
+        return true;
+    }
+
+    bool read_process_cpu_ticks(pid_t pid, unsigned long long& ticks)
+    {
+        if (pid <= 0)
+        {
+            return false;
+        }
+
+        std::ifstream stat_file("/proc/" + std::to_string(pid) + "/stat");
+        if (!stat_file)
+        {
+            return false;
+        }
+
+        std::stringstream content;
+        content << stat_file.rdbuf();
+        return parse_proc_stat_cpu(content.str(), ticks);
+    }
+
+    bool parse_proc_stat_activity(const std::string& stat, char& state, unsigned long long& ticks)
+    {
+        size_t comm_end = stat.rfind(')');
+        if (comm_end == std::string::npos)
+        {
+            return false;
+        }
+
+        // Fields after comm start at 3 (state); utime, stime, cutime and
+        // cstime are 14 to 17
+        std::istringstream fields(stat.substr(comm_end + 1));
+        std::string field;
+        char process_state = 0;
+        unsigned long long total = 0;
+        for (int index = 3; index <= 17; ++index)
+        {
+            if (!(fields >> field))
+            {
+                return false;
+            }
+            try
+            {
+                if (index == 3)
+                    process_state = field[0];
+                else if (index >= 14)
+                    total += static_cast<unsigned long long>(std::stoll(field));
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+
+        state = process_state;
+        ticks = total;
+        return true;
+    }
+
+    bool read_process_activity(pid_t pid, process_activity& activity)
+    {
+        if (pid <= 0)
+        {
+            return false;
+        }
+
+        process_activity total;
+        std::vector<pid_t> pending = {pid};
+        size_t sampled = 0;
+        while (!pending.empty() && sampled < max_sampled_processes)
+        {
+            pid_t current = pending.back();
+            pending.pop_back();
+
+            std::string content;
+            char state = 0;
+            unsigned long long ticks = 0;
+            if (!read_proc_file(current, "stat", content) || !parse_proc_stat_activity(content, state, ticks))
+            {
+                // A descendant may exit between listing and reading it
+                if (current == pid)
+                {
+                    return false;
+                }
+                continue;
+            }
+            ++sampled;
+            total.cpu_ticks += ticks;
+            total.in_disk_wait = total.in_disk_wait || state == 'D';
+
+            resource_sample io;
+            if (read_proc_file(current, "io", content) && parse_proc_io(content, io))
+            {
+                total.io_bytes += io.read_chars + io.write_chars;
+            }
+
+            auto children = read_children(current);
+            pending.insert(pending.end(), children.begin(), children.end());
+        }
+
+        activity = total;
+        return true;
+    }
+
+    execution_watchdog::execution_watchdog(pid_t pid,
+                                           const execution_limits& limits,
+                                           clock::time_point started_at)
+        : m_pid(pid)
+        , m_limits(limits)
+        , m_started_at(started_at)
+        , m_last_progress(started_at)
+        , m_last_sample(started_at)
+        , m_activity_available(read_process_activity(pid, m_activity))
+        , m_soft_reported(false)
+    {
+    }
+
+    void execution_watchdog::note_output(clock::time_point now)
+    {
+        m_last_progress = now;
+    }
+
+    watchdog_verdict execution_watchdog::check(clock::time_point now)
+    {
+        if (m_activity_available && now - m_last_sample >= sample_interval)
+        {
+            // A process that ends lowers the sums; any change is progress
+            process_activity activity;
+            m_activity_available = read_process_activity(m_pid, activity);
+            if (m_activity_available &&
+                (activity.cpu_ticks != m_activity.cpu_ticks || activity.io_bytes != m_activity.io_bytes ||
+                 activity.in_disk_wait))
+            {
+                m_last_progress = now;
+            }
+            m_activity = activity;
+            m_last_sample = now;
+        }
+
+        auto running_for = now - m_started_at;
+        if (m_limits.hard_deadline.count() > 0 && running_for >= m_limits.hard_deadline)
+        {
+            return watchdog_verdict::hard_deadline;
+        }
+        if (m_limits.hang_timeout.count() > 0 && idle_for(now) >= m_limits.hang_timeout)
+        {
+            return watchdog_verdict::hung;
+        }
+        if (!m_soft_reported && m_limits.soft_deadline.count() > 0 &&
+            running_for >= m_limits.soft_deadline)
+        {
+            m_soft_reported = true;
+            return watchdog_verdict::soft_deadline;
+        }
+        return watchdog_verdict::running;
+    }
+
+    std::chrono::milliseconds execution_watchdog::next_check(clock::time_point now) const
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        milliseconds wait = m_activity_available ? sample_interval : milliseconds(60 * 1000);
+        auto until = [&](clock::time_point deadline)
+        {
+            wait = std::min(wait, std::max(milliseconds(0), duration_cast<milliseconds>(deadline - now)));
+        };
+
+        if (m_limits.hard_deadline.count() > 0)
+            until(m_started_at + m_limits.hard_deadline);
+        if (m_limits.hang_timeout.count() > 0)
+            until(m_last_progress + m_limits.hang_timeout);
+        if (!m_soft_reported && m_limits.soft_deadline.count() > 0)
+            until(m_started_at + m_limits.soft_deadline);
+        return wait;
+    }
+
+    execution_watchdog::clock::duration execution_watchdog::idle_for(clock::time_point now) const
+    {
+        return now - m_last_progress;
+    }
+
+} // namespace xeus_sas
@@ -0,0 +1,182 @@
+#include "xeus-sas/resource_usage.hpp"
+#include "xeus-sas/process_watchdog.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace xeus_sas
+{
+    namespace
+    {
+        // Value of a "key: value" or "key value" line; false if the key is absent
+        bool find_counter(const std::string& content, const std::string& key, unsigned long long& value)
+        {
+            size_t pos = 0;
+            while ((pos = content.find(key, pos)) != std::string::npos)
+            {
+                size_t after = pos + key.size();
+                if ((pos == 0 || content[pos - 1] == '\n') && after < content.size() &&
+                    (content[after] == ':' || content[after] == ' ' || content[after] == '\t'))
+                {
+                    return std::sscanf(content.c_str() + after + 1, " %llu", &value) == 1;
+                }
+                pos = after;
+            }
+            return false;
+        }
+
+        unsigned long long delta(unsigned long long from, unsigned long long to)
+        {
+            // Counters only grow; a smaller value means a different process
+            return to >= from ? to - from : 0;
+        }
+
+        std::string format_bytes(unsigned long long bytes)
+        {
+            const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+            double value = static_cast<double>(bytes);
+            size_t unit = 0;
+            while (value >= 1024.0 && unit + 1 < sizeof(units) / sizeof(units[0]))
+            {
+                value /= 1024.0;
+                ++unit;
+            }
+            char text[32];
+            std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+            return text;
+        }
+    }
+
+    bool read_proc_file(pid_t pid, const std::string& name, std::string& content)
+    {
+        std::ifstream file("/proc/" + std::to_string(pid) + "/" + name);
+        if (!file)
+        {
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        content = buffer.str();
+        return !content.empty();
+    }
+
+    bool parse_proc_status(const std::string& status, resource_sample& sample)
+    {
+        bool found = find_counter(status, "VmHWM", sample.peak_rss_kb);
+        found = find_counter(status, "voluntary_ctxt_switches", sample.voluntary_switches) || found;
+        found = find_counter(status, "nonvoluntary_ctxt_switches", sample.involuntary_switches) || found;
+        return found;
+    }
+
+    bool parse_proc_io(const std::string& io, resource_sample& sample)
+    {
+        sample.has_io = find_counter(io, "rchar", sample.read_chars) &&
+                        find_counter(io, "wchar", sample.write_chars) &&
+                        find_counter(io, "read_bytes", sample.read_bytes) &&
+                        find_counter(io, "write_bytes", sample.write_bytes);
+        return sample.has_io;
+    }
+
+    resource_sample sample_process(pid_t pid)
+    {
+        resource_sample sample;
+        std::string content;
+        if (pid <= 0 || !read_proc_file(pid, "stat", content) ||
+            !parse_proc_stat_times(content, sample.user_ticks, sample.system_ticks))
+        {
+            return sample;
+        }
+        sample.valid = true;
+
+        if (read_proc_file(pid, "status", content))
+        {
+            parse_proc_status(content, sample);
+        }
+        if (read_proc_file(pid, "io", content))
+        {
+            parse_proc_io(content, sample);
+        }
+        return sample;
+    }
+
+    bool reset_peak_rss(pid_t pid)
+    {
+        if (pid <= 0)
+        {
+            return false;
+        }
+        std::string path = "/proc/" + std::to_string(pid) + "/clear_refs";
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool reset = write(fd, "5", 1) == 1;
+        close(fd);
+        return reset;
+    }
+
+    resource_usage usage_between(const resource_sample& start, const resource_sample& end, bool peak_reset)
+    {
+        resource_usage usage;
+        if (!start.valid || !end.valid)
+        {
+            return usage;
+        }
+
+        static const double ticks_per_second = static_cast<double>(sysconf(_SC_CLK_TCK));
+        usage.available = true;
+        usage.cpu_user_s = static_cast<double>(delta(start.user_ticks, end.user_ticks)) / ticks_per_second;
+        usage.cpu_system_s = static_cast<double>(delta(start.system_ticks, end.system_ticks)) / ticks_per_second;
+        usage.peak_rss_kb = end.peak_rss_kb;
+        usage.peak_rss_per_cell = peak_reset;
+        usage.voluntary_switches = delta(start.voluntary_switches, end.voluntary_switches);
+        usage.involuntary_switches = delta(start.involuntary_switches, end.involuntary_switches);
+
+        usage.has_io = start.has_io && end.has_io;
+        if (usage.has_io)
+        {
+            usage.read_chars = delta(start.read_chars, end.read_chars);
+            usage.write_chars = delta(start.write_chars, end.write_chars);
+            usage.read_bytes = delta(start.read_bytes, end.read_bytes);
+            usage.write_bytes = delta(start.write_bytes, end.write_bytes);
+        }
+        return usage;
+    }
+
+    std::string format_usage(const resource_usage& usage, double wall_ms)
+    {
+        char text[160];
+        if (!usage.available)
+        {
+            std::snprintf(text, sizeof(text), "SAS: %.1f s wall, resource usage unavailable", wall_ms / 1000.0);
+            return text;
+        }
+
+        std::snprintf(text, sizeof(text), "SAS: %.1f s wall, %.1f s CPU (%.1f user, %.1f sys)",
+                      wall_ms / 1000.0, usage.cpu_user_s + usage.cpu_system_s,
+                      usage.cpu_user_s, usage.cpu_system_s);
+        std::string line = text;
+
+        if (usage.peak_rss_kb > 0)
+        {
+            line += ", peak RSS " + format_bytes(usage.peak_rss_kb * 1024);
+            if (!usage.peak_rss_per_cell)
+            {
+                line += " (session)";
+            }
+        }
+        if (usage.has_io)
+        {
+            line += ", read " + format_bytes(usage.read_bytes) + ", written " + format_bytes(usage.write_bytes);
+        }
+        line += ", " + std::to_string(usage.voluntary_switches) + "/" +
+                std::to_string(usage.involuntary_switches) + " context switches";
+        return line;
+    }
+
+} // namespace xeus_sas
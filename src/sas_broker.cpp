@@ -0,0 +1,606 @@
+#include "xeus-sas/sas_broker.hpp"
+#include "xeus-sas/sas_process.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace xeus_sas
+{
+    namespace
+    {
+        // Longest wait for a warm process when the pool is empty; SAS
+        // startup itself is bounded by wait_until_ready()
+        const std::chrono::seconds lease_wait(90);
+
+        // A client that connects but sends nothing must not hold a thread
+        const std::chrono::seconds request_timeout(10);
+
+        // Most descriptors one message carries
+        const size_t max_message_fds = 8;
+
+        void set_receive_timeout(int socket_fd, std::chrono::seconds timeout)
+        {
+            struct timeval tv;
+            tv.tv_sec = static_cast<time_t>(timeout.count());
+            tv.tv_usec = 0;
+            setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        }
+
+        uid_t peer_user(int socket_fd)
+        {
+#ifdef __linux__
+            struct ucred credentials;
+            socklen_t length = sizeof(credentials);
+            if (getsockopt(socket_fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0)
+            {
+                return credentials.uid;
+            }
+#else
+            uid_t user;
+            gid_t group;
+            if (getpeereid(socket_fd, &user, &group) == 0)
+            {
+                return user;
+            }
+#endif
+            return static_cast<uid_t>(-1);
+        }
+
+        bool make_address(const std::string& path, struct sockaddr_un& address)
+        {
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(address.sun_path))
+            {
+                return false;
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            return true;
+        }
+
+        int open_socket()
+        {
+#ifdef __linux__
+            return socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0)
+            {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+            return fd;
+#endif
+        }
+    }
+
+    std::string default_broker_socket()
+    {
+        const char* socket_path = std::getenv("XEUS_SAS_BROKER");
+        if (socket_path && *socket_path)
+        {
+            return socket_path;
+        }
+
+        // Brokers are per user: never share a default socket with others
+        const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+        if (runtime_dir && *runtime_dir)
+        {
+            return std::string(runtime_dir) + "/xsas-broker.sock";
+        }
+        return "/tmp/xsas-broker-" + std::to_string(geteuid()) + ".sock";
+    }
+
+    bool send_message(int socket_fd, const std::string& line, const std::vector<int>& fds)
+    {
+        std::string text = line + "\n";
+        struct iovec iov;
+        iov.iov_base = &text[0];
+        iov.iov_len = text.size();
+
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+
+        std::vector<char> control;
+        if (!fds.empty())
+        {
+            control.assign(CMSG_SPACE(sizeof(int) * fds.size()), 0);
+            message.msg_control = control.data();
+            message.msg_controllen = control.size();
+            struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_RIGHTS;
+            header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+            std::memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+        }
+
+        // Descriptors travel with the first byte; a short send only leaves text
+        ssize_t sent = sendmsg(socket_fd, &message, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        for (size_t done = static_cast<size_t>(sent); done < text.size();)
+        {
+            ssize_t n = send(socket_fd, text.data() + done, text.size() - done, MSG_NOSIGNAL);
+            if (n <= 0)
+            {
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool receive_message(int socket_fd, std::string& line, std::vector<int>& fds)
+    {
+        // Byte by byte, so a following message (and its descriptors) stays
+        // in the socket; protocol lines are a few bytes long
+        line.clear();
+        fds.clear();
+        while (true)
+        {
+            char c;
+            struct iovec iov;
+            iov.iov_base = &c;
+            iov.iov_len = 1;
+
+            std::vector<char> control(CMSG_SPACE(sizeof(int) * max_message_fds), 0);
+            struct msghdr message;
+            std::memset(&message, 0, sizeof(message));
+            message.msg_iov = &iov;
+            message.msg_iovlen = 1;
+            message.msg_control = control.data();
+            message.msg_controllen = control.size();
+
+#ifdef MSG_CMSG_CLOEXEC
+            ssize_t n = recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC);
+#else
+            ssize_t n = recvmsg(socket_fd, &message, 0);
+#endif
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+
+            for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header;
+                 header = CMSG_NXTHDR(&message, header))
+            {
+                if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+                {
+                    size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    const unsigned char* data = CMSG_DATA(header);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        int fd;
+                        std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+#ifndef MSG_CMSG_CLOEXEC
+                        fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+                        fds.push_back(fd);
+                    }
+                }
+            }
+
+            if (c == '\n')
+            {
+                return true;
+            }
+            line += c;
+        }
+    }
+
+    // lease_ledger
+
+    lease_ledger::lease_ledger(const broker_limits& limits)
+        : m_limits(limits)
+    {
+    }
+
+    bool lease_ledger::acquire(std::string& refusal)
+    {
+        if (m_leased >= m_limits.max_processes)
+        {
+            refusal = "process limit of " + std::to_string(m_limits.max_processes) + " SAS processes reached";
+            return false;
+        }
+        ++m_leased;
+        return true;
+    }
+
+    void lease_ledger::release()
+    {
+        if (m_leased > 0)
+        {
+            --m_leased;
+        }
+    }
+
+    size_t lease_ledger::leased() const
+    {
+        return m_leased;
+    }
+
+    size_t lease_ledger::pool_target(size_t waiting) const
+    {
+        // Warm processes count against the limit like leased ones;
+        // leases still waiting for a process hold none yet
+        size_t holding = m_leased - std::min(waiting, m_leased);
+        return std::min(m_limits.pool_size + waiting, m_limits.max_processes - holding);
+    }
+
+    // sas_broker
+
+    sas_broker::sas_broker(const std::string& sas_path,
+                           const std::string& socket_path,
+                           const broker_limits& limits,
+                           mode_t socket_mode,
+                           const std::vector<std::string>& sas_options)
+        : m_sas_path(sas_path)
+        , m_sas_options(sas_options)
+        , m_socket_path(socket_path)
+        , m_listen_fd(-1)
+        , m_stopping(false)
+        , m_ledger(limits)
+        , m_starting(0)
+        , m_waiting(0)
+    {
+        struct sockaddr_un address;
+        if (!make_address(socket_path, address))
+        {
+            throw std::runtime_error("Invalid broker socket path: " + socket_path);
+        }
+
+        // Refuse to take over the socket of a broker that is still running
+        int probe = open_socket();
+        if (probe >= 0 && connect(probe, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0)
+        {
+            close(probe);
+            throw std::runtime_error("A SAS broker is already listening on " + socket_path);
+        }
+        if (probe >= 0)
+        {
+            close(probe);
+        }
+        unlink(socket_path.c_str());
+
+        m_listen_fd = open_socket();
+        if (m_listen_fd < 0 ||
+            bind(m_listen_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+            chmod(socket_path.c_str(), socket_mode) != 0 ||
+            listen(m_listen_fd, 64) != 0)
+        {
+            std::string error = std::strerror(errno);
+            if (m_listen_fd >= 0)
+            {
+                close(m_listen_fd);
+            }
+            throw std::runtime_error("Cannot listen on " + socket_path + ": " + error);
+        }
+        fcntl(m_listen_fd, F_SETFL, fcntl(m_listen_fd, F_GETFL, 0) | O_NONBLOCK);
+        m_poller.add(m_listen_fd, true);
+
+        std::cerr << "SAS broker listening on " << socket_path << " (pool " << limits.pool_size
+                  << ", at most " << limits.max_processes << " processes)" << std::endl;
+
+        m_refill = std::thread(&sas_broker::refill_loop, this);
+    }
+
+    sas_broker::~sas_broker()
+    {
+        stop();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_changed.notify_all();
+        }
+        if (m_refill.joinable())
+        {
+            m_refill.join();
+        }
+
+        // Ending the connections makes each lease end its SAS process
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& client : m_leases)
+            {
+                shutdown(client.socket_fd, SHUT_RDWR);
+            }
+        }
+        for (auto& client : m_leases)
+        {
+            if (client.worker.joinable())
+            {
+                client.worker.join();
+            }
+        }
+        m_leases.clear();
+        m_pool.clear();
+
+        if (m_listen_fd >= 0)
+        {
+            close(m_listen_fd);
+            unlink(m_socket_path.c_str());
+        }
+        std::cerr << "SAS broker stopped" << std::endl;
+    }
+
+    void sas_broker::run()
+    {
+        std::vector<poll_event> events;
+        while (!m_stopping)
+        {
+            m_poller.wait(events, 1000);
+            if (!m_stopping)
+            {
+                accept_clients();
+            }
+            prune_leases();
+        }
+    }
+
+    void sas_broker::stop()
+    {
+        m_stopping = true;
+        m_poller.wake();
+    }
+
+    void sas_broker::accept_clients()
+    {
+        while (true)
+        {
+#ifdef __linux__
+            int client_fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+            int client_fd = accept(m_listen_fd, nullptr, nullptr);
+            if (client_fd >= 0)
+            {
+                fcntl(client_fd, F_SETFD, FD_CLOEXEC);
+            }
+#endif
+            if (client_fd < 0)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_leases.emplace_back();
+            lease& client = m_leases.back();
+            client.socket_fd = client_fd;
+            client.user = peer_user(client_fd);
+            client.worker = std::thread(&sas_broker::serve_lease, this, std::ref(client));
+        }
+    }
+
+    void sas_broker::prune_leases()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_leases.begin(); it != m_leases.end();)
+        {
+            if (it->finished)
+            {
+                it->worker.join();
+                it = m_leases.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void sas_broker::serve_lease(lease& client)
+    {
+        int fd = client.socket_fd;
+        std::string line;
+        std::vector<int> fds;
+        set_receive_timeout(fd, request_timeout);
+
+        std::string refusal;
+        bool granted = false;
+        if (client.user == static_cast<uid_t>(-1))
+        {
+            refusal = "peer credentials unavailable";
+        }
+        else if (client.user != geteuid())
+        {
+            // SAS runs as the broker's user; a lease would hand another
+            // user code execution as this one
+            refusal = "leases are only granted to the broker's own user";
+        }
+        else if (!receive_message(fd, line, fds) || line != "LEASE")
+        {
+            refusal = "expected LEASE";
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            granted = m_ledger.acquire(refusal);
+            m_changed.notify_all();
+        }
+        for (int received : fds)
+        {
+            close(received);
+        }
+
+        std::unique_ptr<sas_process> process;
+        if (granted)
+        {
+            process = take_warm_process();
+            if (!process)
+            {
+                refusal = "no SAS process became ready";
+            }
+        }
+
+        if (process && send_message(fd, "OK " + std::to_string(process->pid()),
+                                    {process->input_fd(), process->output_fd(),
+                                     process->log_fd(), process->listing_fd()}))
+        {
+            std::cerr << "Leased SAS process " << process->pid() << " to user " << client.user << std::endl;
+            set_receive_timeout(fd, std::chrono::seconds(0));
+
+            // The connection is the lease; watch it and the process together
+            event_poller poller;
+            poller.add(fd, true);
+            if (process->exit_fd() >= 0)
+            {
+                poller.add(process->exit_fd(), true);
+            }
+
+            std::vector<poll_event> events;
+            bool connected = true;
+            while (connected && !m_stopping)
+            {
+                if (process->has_exited())
+                {
+                    send_message(fd, "EXIT " + std::to_string(process->exit_status()));
+                    std::cerr << "Leased SAS process " << process->pid() << " "
+                              << process->exit_description() << std::endl;
+                    break;
+                }
+
+                // Without a pidfd, exit is noticed by polling
+                poller.wait(events, process->exit_fd() >= 0 ? -1 : 1000);
+                for (const auto& ev : events)
+                {
+                    if (ev.fd != fd)
+                    {
+                        continue;
+                    }
+                    if (!receive_message(fd, line, fds))
+                    {
+                        connected = false;
+                    }
+                    else if (line == "INTERRUPT")
+                    {
+                        kill(process->pid(), SIGINT);
+                    }
+                    for (int received : fds)
+                    {
+                        close(received);
+                    }
+                }
+            }
+        }
+        else
+        {
+            if (granted && !process)
+            {
+                std::cerr << "Lease for user " << client.user << " failed: " << refusal << std::endl;
+            }
+            else if (!granted)
+            {
+                std::cerr << "Refused lease for user " << client.user << ": " << refusal << std::endl;
+            }
+            send_message(fd, "ERR " + refusal);
+        }
+
+        // End SAS (ENDSAS, then signals) before the slot is given back
+        process.reset();
+        close(fd);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (granted)
+        {
+            m_ledger.release();
+        }
+        m_changed.notify_all();
+        client.finished = true;
+        m_poller.wake();
+    }
+
+    std::unique_ptr<sas_process> sas_broker::take_warm_process()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto deadline = std::chrono::steady_clock::now() + lease_wait;
+        ++m_waiting;
+        m_changed.notify_all();
+
+        std::unique_ptr<sas_process> process;
+        while (!process && !m_stopping)
+        {
+            while (!process && !m_pool.empty())
+            {
+                process = std::move(m_pool.front());
+                m_pool.pop_front();
+                if (process->has_exited())
+                {
+                    std::cerr << "Dropping warm SAS process " << process->pid() << ": "
+                              << process->exit_description() << std::endl;
+                    process.reset();
+                }
+            }
+            if (!process && m_changed.wait_until(lock, deadline) == std::cv_status::timeout &&
+                m_pool.empty())
+            {
+                break;
+            }
+        }
+
+        --m_waiting;
+        m_changed.notify_all();
+        return process;
+    }
+
+    void sas_broker::refill_loop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopping)
+        {
+            if (m_pool.size() + m_starting >= m_ledger.pool_target(m_waiting))
+            {
+                m_changed.wait(lock);
+                continue;
+            }
+
+            ++m_starting;
+            lock.unlock();
+            std::unique_ptr<sas_process> process;
+            try
+            {
+                auto started_at = std::chrono::steady_clock::now();
+                process = sas_process::spawn(m_sas_path, m_sas_options);
+                process->wait_until_ready(std::chrono::seconds(60));
+                std::cerr << "Warm SAS process ready (PID: " << process->pid() << ") after "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - started_at).count()
+                          << " ms" << std::endl;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to start SAS: " << e.what() << std::endl;
+            }
+            lock.lock();
+
+            --m_starting;
+            if (process)
+            {
+                m_pool.push_back(std::move(process));
+                m_changed.notify_all();
+            }
+            else
+            {
+                // Do not spin on a SAS that cannot start
+                m_changed.wait_for(lock, std::chrono::seconds(5));
+            }
+        }
+    }
+
+} // namespace xeus_sas
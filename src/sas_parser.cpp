@@ -1,8 +1,10 @@
 #include "xeus-sas/sas_parser.hpp"
 
 #include <algorithm>
+#include <cctype>
 #include <regex>
 #include <sstream>
+#include <cstdio>
 #include <random>
 
 namespace xeus_sas
@@ -184,12 +186,34 @@ namespace xeus_sas
 
     std::string generate_execution_marker()
     {
-        // Generate a unique marker for execution tracking
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_int_distribution<> dis(100000, 999999);
+        // 64 random bits per marker: user output cannot realistically collide
+        // with it. Sessions run on separate threads, so each has its own engine.
+        thread_local std::mt19937_64 gen(std::random_device{}());
+
+        char digits[17];
+        std::snprintf(digits, sizeof(digits), "%016llx",
+                      static_cast<unsigned long long>(gen()));
+        return std::string("XEUS_SAS_MARKER_") + digits;
+    }
 
-        return "XEUS_SAS_MARKER_" + std::to_string(dis(gen));
+    bool touches_ods(const std::string& code)
+    {
+        auto is_word = [](char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '&' || c == '%';
+        };
+        for (size_t pos = 0; pos + 3 < code.size(); ++pos)
+        {
+            if (std::tolower(static_cast<unsigned char>(code[pos])) == 'o' &&
+                std::tolower(static_cast<unsigned char>(code[pos + 1])) == 'd' &&
+                std::tolower(static_cast<unsigned char>(code[pos + 2])) == 's' &&
+                std::isspace(static_cast<unsigned char>(code[pos + 3])) &&
+                (pos == 0 || !is_word(code[pos - 1])))
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
     bool should_show_listing(const execution_result& result)
@@ -0,0 +1,564 @@
+#include "xeus-sas/sas_process.hpp"
+#include "xeus-sas/event_poller.hpp"
+#include "xeus-sas/stream_scanner.hpp"
+#include "xeus-sas/process_watchdog.hpp"
+#include "xeus-sas/sas_broker.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+extern char** environ;
+
+namespace xeus_sas
+{
+    namespace
+    {
+        // Every descriptor we create is close-on-exec from the start, so SAS
+        // (and anything else the kernel starts) only inherits what the spawn
+        // file actions hand it explicitly
+        bool open_pipe(int fds[2])
+        {
+#ifdef __linux__
+            return pipe2(fds, O_CLOEXEC) == 0;
+#else
+            if (pipe(fds) != 0)
+            {
+                return false;
+            }
+            fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+            return true;
+#endif
+        }
+    }
+
+    std::unique_ptr<sas_process> sas_process::spawn(const std::string& sas_path,
+                                                    const std::vector<std::string>& options)
+    {
+        // Create pipes for stdin, stdout, stderr and the listing
+        int pipes[4][2] = {{-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}};
+        int (&stdin_pipe)[2] = pipes[0];
+        int (&stdout_pipe)[2] = pipes[1];
+        int (&stderr_pipe)[2] = pipes[2];
+        int (&listing_pipe)[2] = pipes[3];
+
+        auto close_pipes = [&pipes]()
+        {
+            for (auto& ends : pipes)
+            {
+                for (int fd : ends)
+                {
+                    if (fd >= 0)
+                    {
+                        close(fd);
+                    }
+                }
+            }
+        };
+
+        for (auto& ends : pipes)
+        {
+            if (!open_pipe(ends))
+            {
+                close_pipes();
+                throw std::runtime_error("Failed to create pipes for SAS communication");
+            }
+        }
+
+        // posix_spawn instead of fork: the kernel process holds ZeroMQ
+        // threads and a potentially large heap, which fork would have to
+        // duplicate page tables for only to exec right away. dup2 clears
+        // close-on-exec on the targets; fds 0-2 are set up first because a
+        // pipe end may itself be descriptor 3.
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, stdin_pipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, stdout_pipe[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, stderr_pipe[1], STDERR_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, listing_pipe[1], listing_fd_number);
+
+        // Own process group: terminal signals aimed at the kernel (Ctrl-C in
+        // a console) do not reach SAS. The kernel ignores SIGPIPE; SAS gets
+        // default dispositions and an empty signal mask.
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        sigset_t default_signals;
+        sigemptyset(&default_signals);
+        sigaddset(&default_signals, SIGPIPE);
+        sigaddset(&default_signals, SIGINT);
+        sigset_t no_signals;
+        sigemptyset(&no_signals);
+        posix_spawnattr_setsigdefault(&attributes, &default_signals);
+        posix_spawnattr_setsigmask(&attributes, &no_signals);
+        posix_spawnattr_setpgroup(&attributes, 0);
+        posix_spawnattr_setflags(&attributes,
+                                 POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+        // Start SAS in interactive mode
+        // -nodms: no display manager
+        // -rsasuser: reuse sasuser library (faster startup)
+        // -noovp: no OVP processing
+        // -nosyntaxcheck: no pre-execution syntax check (faster execution)
+        // -nonews: suppress startup news
+        // -noaltlog: no alternate log
+        // -noaltprint: no alternate print
+        // -stdio: use stdin/stdout for I/O
+        // followed by the host's launch profile (-memsize, -cpucount, ...)
+        std::vector<std::string> args = {
+            sas_path, "-nodms", "-rsasuser", "-noovp", "-nosyntaxcheck",
+            "-nonews", "-noaltlog", "-noaltprint", "-stdio"
+        };
+        args.insert(args.end(), options.begin(), options.end());
+        std::vector<char*> argv;
+        for (auto& arg : args)
+        {
+            argv.push_back(&arg[0]);
+        }
+        argv.push_back(nullptr);
+
+        pid_t pid = -1;
+        int error = posix_spawnp(&pid, sas_path.c_str(), &actions, &attributes, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attributes);
+
+        if (error != 0)
+        {
+            close_pipes();
+            throw std::runtime_error("Failed to execute SAS: " + sas_path + ": " + std::strerror(error));
+        }
+
+        // Parent process - keep our ends of the pipes
+        close(stdin_pipe[0]);
+        close(stdout_pipe[1]);
+        close(stderr_pipe[1]);
+        close(listing_pipe[1]);
+
+        std::unique_ptr<sas_process> process(new sas_process());
+        process->m_pid = pid;
+        process->m_stdin_fd = stdin_pipe[1];
+        process->m_stdout_fd = stdout_pipe[0];
+        process->m_stderr_fd = stderr_pipe[0];
+        process->m_listing_fd = listing_pipe[0];
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+        // Lets pollers learn about SAS exiting the moment it happens (Linux
+        // 5.3+); elsewhere exit is noticed through EOF and waitpid
+        process->m_pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#endif
+
+        // Code is written from the read loop as the pipe drains; a blocking
+        // write could deadlock against SAS filling its output pipes
+        fcntl(process->m_stdin_fd, F_SETFL, fcntl(process->m_stdin_fd, F_GETFL, 0) | O_NONBLOCK);
+
+        return process;
+    }
+
+    std::unique_ptr<sas_process> sas_process::lease(const std::string& broker_socket)
+    {
+        struct sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (broker_socket.empty() || broker_socket.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("Invalid SAS broker socket: " + broker_socket);
+        }
+        std::memcpy(address.sun_path, broker_socket.c_str(), broker_socket.size() + 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error(std::string("Cannot create broker socket: ") + std::strerror(errno));
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            std::string error = std::strerror(errno);
+            close(fd);
+            throw std::runtime_error("Cannot reach SAS broker at " + broker_socket + ": " + error);
+        }
+
+        // The broker may have to start SAS first when its pool is empty
+        struct timeval timeout;
+        timeout.tv_sec = 120;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::string reply;
+        std::vector<int> fds;
+        bool answered = send_message(fd, "LEASE") && receive_message(fd, reply, fds);
+        if (!answered || reply.compare(0, 3, "OK ") != 0 || fds.size() != 4)
+        {
+            for (int received : fds)
+            {
+                close(received);
+            }
+            close(fd);
+            if (reply.compare(0, 4, "ERR ") == 0)
+            {
+                throw std::runtime_error("SAS broker refused the lease: " + reply.substr(4));
+            }
+            throw std::runtime_error("No SAS process from broker at " + broker_socket +
+                                     (reply.empty() ? "" : ": " + reply));
+        }
+
+        timeout.tv_sec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::unique_ptr<sas_process> process(new sas_process());
+        process->m_pid = static_cast<pid_t>(std::atol(reply.c_str() + 3));
+        process->m_stdin_fd = fds[0];
+        process->m_stdout_fd = fds[1];
+        process->m_stderr_fd = fds[2];
+        process->m_listing_fd = fds[3];
+        process->m_lease_fd = fd;
+
+        // Relative paths in user code should resolve where a spawned SAS
+        // would have started; the log of this step is discarded with the
+        // banner by wait_until_ready()
+        char* cwd = getcwd(nullptr, 0);
+        if (cwd)
+        {
+            std::string quoted;
+            for (const char* c = cwd; *c; ++c)
+            {
+                quoted += (*c == '\'') ? "\'\'" : std::string(1, *c);
+            }
+            std::free(cwd);
+            std::string chdir_code = "data _null_; rc = dlgcdir('" + quoted + "'); run;\n";
+            ssize_t ignored = write(process->m_stdin_fd, chdir_code.data(), chdir_code.size());
+            (void)ignored;
+        }
+        return process;
+    }
+
+    sas_process::~sas_process()
+    {
+        terminate();
+    }
+
+    void sas_process::wait_until_ready(std::chrono::milliseconds timeout)
+    {
+        // %str() keeps the echoed source line from matching the sentinel
+        const std::string sentinel = "XEUS_SAS_READY";
+        const std::string probe = "%put XEUS_SAS_%str()READY;\n";
+        if (write(m_stdin_fd, probe.data(), probe.size()) != static_cast<ssize_t>(probe.size()))
+        {
+            throw std::runtime_error("Failed to write to SAS");
+        }
+
+        int stdout_flags = fcntl(m_stdout_fd, F_GETFL, 0);
+        int stderr_flags = fcntl(m_stderr_fd, F_GETFL, 0);
+        fcntl(m_stdout_fd, F_SETFL, stdout_flags | O_NONBLOCK);
+        fcntl(m_stderr_fd, F_SETFL, stderr_flags | O_NONBLOCK);
+
+        event_poller poller;
+        poller.add(m_stdout_fd, true);
+        poller.add(m_stderr_fd, true);
+
+        stream_scanner scanner({sentinel});
+        std::vector<scan_match> matches;
+        std::vector<poll_event> events;
+        char buffer[8192];
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool ready = false;
+        bool closed = false;
+
+        // Discard the banner; stdout is drained too so SAS never blocks on it
+        while (!ready && !closed)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0)
+            {
+                break;
+            }
+
+            poller.wait(events, static_cast<int>(remaining.count()) + 1);
+            for (const auto& ev : events)
+            {
+                ssize_t bytes_read;
+                while ((bytes_read = read(ev.fd, buffer, sizeof(buffer))) > 0)
+                {
+                    if (ev.fd == m_stderr_fd)
+                    {
+                        scanner.feed(buffer, static_cast<size_t>(bytes_read), matches);
+                    }
+                }
+                closed = closed || (bytes_read == 0);
+            }
+            ready = !matches.empty();
+        }
+
+        fcntl(m_stdout_fd, F_SETFL, stdout_flags);
+        fcntl(m_stderr_fd, F_SETFL, stderr_flags);
+
+        if (!ready)
+        {
+            throw std::runtime_error(closed ? "SAS exited during startup"
+                                            : "Timed out waiting for SAS to start");
+        }
+    }
+
+    void sas_process::terminate(std::chrono::milliseconds grace)
+    {
+        // Send ENDSAS command to gracefully terminate SAS. If the pipe is
+        // full, closing it still ends SAS at end of input.
+        if (m_stdin_fd >= 0)
+        {
+            const char endsas[] = "endsas;\n";
+            ssize_t ignored = write(m_stdin_fd, endsas, sizeof(endsas) - 1);
+            (void)ignored;
+            close(m_stdin_fd);
+            m_stdin_fd = -1;
+        }
+
+        bool abandoned = false;
+        if (m_lease_fd >= 0)
+        {
+            // The broker owns a leased SAS: ending the lease makes it end
+            // the process, escalating to signals as needed
+            if (m_pid > 0 && !wait_for_exit(grace))
+            {
+                std::cerr << "SAS (PID: " << m_pid << ") did not exit after ENDSAS; leaving it to the broker"
+                          << std::endl;
+            }
+            close(m_lease_fd);
+            m_lease_fd = -1;
+        }
+        // Escalate if SAS does not go away by itself. Signals go to the whole
+        // process group so helpers started by SAS go too.
+        else if (m_pid > 0 && !wait_for_exit(grace))
+        {
+            std::cerr << "SAS (PID: " << m_pid << ") did not exit after ENDSAS; sending SIGTERM" << std::endl;
+            kill(-m_pid, SIGTERM);
+            if (!wait_for_exit(grace))
+            {
+                std::cerr << "SAS (PID: " << m_pid << ") ignored SIGTERM; sending SIGKILL" << std::endl;
+                kill(-m_pid, SIGKILL);
+                // A process in uninterruptible sleep (hung NFS, dying disk)
+                // outlives SIGKILL; do not hang the kernel waiting for it
+                if (!wait_for_exit(grace))
+                {
+                    std::cerr << "SAS (PID: " << m_pid << ") still running after SIGKILL; abandoning it"
+                              << std::endl;
+                    abandoned = true;
+                }
+            }
+        }
+
+        for (int* fd : {&m_stdout_fd, &m_stderr_fd, &m_listing_fd, &m_pidfd})
+        {
+            if (*fd >= 0)
+            {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+
+        if (m_pid > 0)
+        {
+            if (!abandoned)
+            {
+                std::cout << "SAS process terminated (PID: " << m_pid << ", " << exit_description() << ")"
+                          << std::endl;
+            }
+            m_pid = -1;
+        }
+    }
+
+    bool sas_process::wait_for_exit(std::chrono::milliseconds timeout)
+    {
+        // SAS keeps writing its log while it shuts down; keep draining the
+        // pipes so it never blocks on a full one (or dies of SIGPIPE before
+        // cleaning up WORK)
+        event_poller poller;
+        for (int fd : {m_stdout_fd, m_stderr_fd, m_listing_fd})
+        {
+            if (fd >= 0)
+            {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+                poller.add(fd, true);
+            }
+        }
+        int exit_notifier = exit_fd();
+        if (exit_notifier >= 0)
+        {
+            poller.add(exit_notifier, true);
+        }
+
+        // Without a pidfd or lease, exit is noticed by polling
+        const std::chrono::milliseconds poll_interval(exit_notifier >= 0 ? 1000 : 20);
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::vector<poll_event> events;
+        char buffer[8192];
+
+        while (!has_exited())
+        {
+            auto wait = poll_interval;
+            if (timeout.count() >= 0)
+            {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                if (remaining.count() <= 0)
+                {
+                    return false;
+                }
+                wait = std::min(wait, remaining);
+            }
+
+            poller.wait(events, static_cast<int>(wait.count()) + 1);
+            for (const auto& ev : events)
+            {
+                if (ev.fd == exit_notifier)
+                {
+                    continue;
+                }
+                ssize_t bytes_read;
+                while ((bytes_read = read(ev.fd, buffer, sizeof(buffer))) > 0)
+                {
+                }
+                if (bytes_read == 0)
+                {
+                    poller.remove(ev.fd);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool sas_process::has_exited()
+    {
+        if (m_exited || m_pid <= 0)
+        {
+            return true;
+        }
+
+        if (m_lease_fd >= 0)
+        {
+            // Not our child: the broker reports the exit over the lease, and
+            // a broker that goes away takes the lease with it
+            char next;
+            ssize_t peeked = recv(m_lease_fd, &next, 1, MSG_PEEK | MSG_DONTWAIT);
+            if (peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            {
+                return false;
+            }
+
+            std::string message;
+            std::vector<int> fds;
+            bool received = peeked > 0 && receive_message(m_lease_fd, message, fds);
+            for (int fd : fds)
+            {
+                close(fd);
+            }
+            if (received && message.compare(0, 5, "EXIT ") != 0)
+            {
+                return false;
+            }
+            m_exited = true;
+            m_exit_status = received ? std::atoi(message.c_str() + 5) : -1;
+            return true;
+        }
+
+        int status = 0;
+        pid_t reaped = waitpid(m_pid, &status, WNOHANG);
+        if (reaped == m_pid || (reaped < 0 && errno == ECHILD))
+        {
+            m_exited = true;
+            m_exit_status = (reaped == m_pid) ? status : -1;
+        }
+        return m_exited;
+    }
+
+    std::string sas_process::exit_description() const
+    {
+        if (!m_exited || m_exit_status < 0)
+        {
+            return "exit status unknown";
+        }
+        if (WIFSIGNALED(m_exit_status))
+        {
+            int signal_number = WTERMSIG(m_exit_status);
+            return "killed by signal " + std::to_string(signal_number) + " (" + strsignal(signal_number) + ")";
+        }
+        return "exited with status " + std::to_string(WEXITSTATUS(m_exit_status));
+    }
+
+    int sas_process::exit_status() const
+    {
+        return m_exited ? m_exit_status : -1;
+    }
+
+    bool sas_process::interrupt()
+    {
+        if (m_lease_fd >= 0)
+        {
+            return send_message(m_lease_fd, "INTERRUPT");
+        }
+        return m_pid > 0 && kill(m_pid, SIGINT) == 0;
+    }
+
+    std::chrono::milliseconds sas_process::default_shutdown_grace()
+    {
+        const char* grace = std::getenv("XEUS_SAS_SHUTDOWN_GRACE");
+        if (grace)
+        {
+            try
+            {
+                return parse_duration(grace);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Warning: Ignoring XEUS_SAS_SHUTDOWN_GRACE: " << e.what() << std::endl;
+            }
+        }
+        return std::chrono::seconds(5);
+    }
+
+    pid_t sas_process::pid() const
+    {
+        return m_pid;
+    }
+
+    int sas_process::input_fd() const
+    {
+        return m_stdin_fd;
+    }
+
+    int sas_process::output_fd() const
+    {
+        return m_stdout_fd;
+    }
+
+    int sas_process::log_fd() const
+    {
+        return m_stderr_fd;
+    }
+
+    int sas_process::listing_fd() const
+    {
+        return m_listing_fd;
+    }
+
+    int sas_process::exit_fd() const
+    {
+        return m_lease_fd >= 0 ? m_lease_fd : m_pidfd;
+    }
+
+} // namespace xeus_sas
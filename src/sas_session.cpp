@@ -1,11 +1,25 @@
 #include "xeus-sas/sas_session.hpp"
 #include "xeus-sas/sas_parser.hpp"
+#include "xeus-sas/sas_process.hpp"
+#include "xeus-sas/sas_broker.hpp"
+#include "xeus-sas/event_poller.hpp"
+#include "xeus-sas/process_watchdog.hpp"
+#include "xeus-sas/resource_usage.hpp"
+#include "xeus-sas/launch_profile.hpp"
+#include "xeus-sas/scratch_directory.hpp"
+#include "xeus-sas/stream_scanner.hpp"
+#include "xeus-sas/html_pipeline.hpp"
+#include "xeus-sas/html_postprocess.hpp"
+#include "xeus-sas/work_checkpoint.hpp"
 #include "xeus-sas/xeus_sas_config.hpp"
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <stdexcept>
 #include <array>
@@ -14,6 +28,11 @@
 #include <regex>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -23,10 +42,306 @@
 #include <signal.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/uio.h>
 #endif
 
 namespace xeus_sas
 {
+    namespace
+    {
+        // Patterns scanned on each stream, by stream_scanner index. The frame
+        // sentinels come first; top-level <div> boundaries are tracked on stdout.
+        enum output_pattern : size_t
+        {
+            begin_pattern = 0,
+            end_pattern,
+            div_open,
+            div_close,
+            output_pattern_count
+        };
+
+        /**
+         * @brief Sentinels framing one execution, derived from a random nonce
+         */
+        struct frame_markers
+        {
+            explicit frame_markers(const std::string& nonce)
+                : begin(nonce + "_BEGIN")
+                , end(nonce + "_END")
+            {
+            }
+
+            // As written in SAS code: %str() splits the literal so that the
+            // echoed source line in the log never matches
+            static std::string quoted(const std::string& marker)
+            {
+                std::string result = marker;
+                result.insert(result.find('_', result.find('_') + 1) + 1, "%str()");
+                return result;
+            }
+
+            std::string begin;
+            std::string end;
+        };
+
+        /**
+         * @brief Classify a log line written after a sentinel step's putlog
+         *
+         * A step that writes to STDOUT notes how many records it wrote
+         * ("NOTE: 1 record was written to the file STDOUT.", followed by
+         * indented record lengths), then its timing ("NOTE: DATA statement
+         * used", followed by indented times).
+         *
+         * @return 1 for the record note, 2 for the timing note, 0 otherwise
+         */
+        int sentinel_step_note(const std::string& line)
+        {
+            static const std::string note = "NOTE: ";
+            static const std::string timing = "DATA statement used";
+            if (line.compare(0, note.size(), note) != 0)
+            {
+                return 0;
+            }
+            if (line.compare(note.size(), timing.size(), timing) == 0)
+            {
+                return 2;
+            }
+            size_t digits_end = line.find_first_not_of("0123456789", note.size());
+            if (digits_end == note.size() || digits_end == std::string::npos)
+            {
+                return 0;
+            }
+            size_t text_end = line.find_last_not_of(" \r");
+            std::string text = line.substr(digits_end, text_end + 1 - digits_end);
+            return (text == " record was written to the file STDOUT." ||
+                    text == " records were written to the file STDOUT.") ? 1 : 0;
+        }
+
+        /**
+         * @brief Incremental state for one framed SAS output stream
+         *
+         * Only the bytes between the begin sentinel line and the end sentinel
+         * belong to the execution. Bytes before the begin line (late output
+         * of an earlier block, log lines of the flush step) are never stored,
+         * and the end sentinel is cut by truncation, so framing costs no copy
+         * of the payload.
+         *
+         * Every chunk passes through a stream_scanner exactly once, so a
+         * sentinel is found even when a read splits it. On stdout, each
+         * top-level <div>...</div> (one ODS output object) is cut out as soon
+         * as its closing tag arrives; on the log, complete lines are handed
+         * out as they arrive.
+         */
+        struct output_stream
+        {
+            output_stream(const frame_markers& markers, bool track_html)
+                : scanner(track_html
+                      ? std::vector<std::string>{markers.begin, markers.end, "<div", "</div>"}
+                      : std::vector<std::string>{markers.begin, markers.end})
+            {
+            }
+
+            /**
+             * @brief Append a chunk, stopping at the end sentinel if it completes here
+             * @return true once the end sentinel has been seen
+             */
+            bool append(const char* chunk, size_t length)
+            {
+                size_t chunk_offset = scanner.bytes_scanned();
+                matches.clear();
+                scanner.feed(chunk, length, matches);
+
+                size_t pos = 0;                   // First chunk byte not yet handled
+                auto next_match = matches.begin();
+
+                if (framing == frame_state::before_begin)
+                {
+                    while (next_match != matches.end() && next_match->pattern != begin_pattern)
+                    {
+                        ++next_match;
+                    }
+                    if (next_match == matches.end())
+                    {
+                        return false;
+                    }
+                    pos = next_match->offset + scanner.pattern_length(begin_pattern) - chunk_offset;
+                    ++next_match;
+                    framing = frame_state::in_begin_line;
+                }
+
+                if (framing == frame_state::in_begin_line)
+                {
+                    const void* newline = std::memchr(chunk + pos, '\n', length - pos);
+                    if (!newline)
+                    {
+                        return false;
+                    }
+                    pos = static_cast<const char*>(newline) - chunk + 1;
+                    framing = frame_state::open;
+                    base = chunk_offset + pos;
+                    consumed = base;
+                }
+
+                data.append(chunk + pos, length - pos);
+
+                for (; next_match != matches.end(); ++next_match)
+                {
+                    const auto& match = *next_match;
+                    if (match.offset < base)
+                    {
+                        continue;
+                    }
+
+                    if (match.pattern == end_pattern)
+                    {
+                        // Bytes after the end sentinel line already belong to the
+                        // next pipelined submission
+                        size_t sentinel_end = match.offset - base + scanner.pattern_length(end_pattern);
+                        size_t line_end = data.find('\n', sentinel_end);
+                        rest.assign(data, line_end == std::string::npos ? sentinel_end : line_end + 1,
+                                    std::string::npos);
+
+                        // Drop the sentinel and everything after it. If nothing but
+                        // whitespace precedes it on its line, drop that line too.
+                        data.resize(match.offset - base);
+                        size_t line_start = data.find_last_of('\n');
+                        line_start = (line_start == std::string::npos) ? 0 : line_start + 1;
+                        if (data.find_first_not_of(" \t\r", line_start) == std::string::npos)
+                        {
+                            data.resize(line_start);
+                        }
+                        delivered = std::min(delivered, data.size());
+                        done = true;
+                        break;
+                    }
+
+                    if (match.pattern == div_open && div_depth++ == 0)
+                    {
+                        block_start = match.offset;
+                    }
+                    else if (match.pattern == div_close && div_depth > 0 && --div_depth == 0)
+                    {
+                        size_t block_end = match.offset + scanner.pattern_length(div_close);
+                        blocks.push_back(data.substr(block_start - base, block_end - block_start));
+                        consumed = block_end;
+                    }
+                }
+
+                // Streaming callers do not need blocks that were already cut out
+                if (discard_consumed && consumed > base)
+                {
+                    data.erase(0, consumed - base);
+                    base = consumed;
+                }
+                return done;
+            }
+
+            /**
+             * @brief Drop the notes of a begin sentinel step that used putlog
+             *
+             * They follow the log sentinel and so arrive at the start of the
+             * block: the record note, the timing note and the indented lines
+             * of each (see sentinel_step_note()). The first line must be one
+             * of the notes, and nothing but indented lines may follow the
+             * timing note. Waits for complete lines.
+             */
+            void drop_step_notes()
+            {
+                size_t pos = 0;
+                int last_note = 0;
+                while (skip_step_notes)
+                {
+                    size_t line_end = data.find('\n', pos);
+                    if (line_end == std::string::npos)
+                    {
+                        // A partial note line at the very end is kept
+                        skip_step_notes = !done;
+                        break;
+                    }
+                    bool indented = line_end == pos || data[pos] == ' ' || data[pos] == '\r';
+                    int note = (last_note < 2 && !indented)
+                        ? sentinel_step_note(data.substr(pos, line_end - pos))
+                        : 0;
+                    if (note > last_note)
+                    {
+                        last_note = note;
+                    }
+                    else if (last_note == 0 || !indented)
+                    {
+                        skip_step_notes = false;
+                        break;
+                    }
+                    pos = line_end + 1;
+                }
+                if (pos > 0 && !skip_step_notes)
+                {
+                    data.erase(0, pos);
+                    base += pos;
+                }
+            }
+
+            /**
+             * @brief Take the complete lines not handed out yet
+             *
+             * Once flush_lines is set, a trailing partial line is included.
+             */
+            std::string take_lines()
+            {
+                drop_step_notes();
+                if (skip_step_notes)
+                {
+                    return std::string();
+                }
+                size_t end = flush_lines ? data.size() : data.find_last_of('\n');
+                if (end == std::string::npos || end + (flush_lines ? 0 : 1) <= delivered)
+                {
+                    return std::string();
+                }
+                end += flush_lines ? 0 : 1;
+                std::string lines = data.substr(delivered, end - delivered);
+                delivered = end;
+                return lines;
+            }
+
+            /**
+             * @brief Framed output not cut out as a block (offset into data)
+             */
+            size_t unconsumed() const
+            {
+                return consumed > base ? consumed - base : 0;
+            }
+
+            enum class frame_state
+            {
+                before_begin,    // Discarding until the begin sentinel
+                in_begin_line,   // Discarding the rest of the begin sentinel line
+                open             // Storing output
+            };
+
+            std::string data;                     // Framed bytes not yet discarded
+            std::string rest;                     // Bytes read past the end sentinel line
+            stream_scanner scanner;
+            std::vector<scan_match> matches;
+            std::vector<std::string> blocks;      // Completed top-level <div> blocks
+            frame_state framing = frame_state::before_begin;
+            size_t base = 0;                      // Stream offset of data[0]
+            size_t consumed = 0;                  // Stream offset after the last block
+            size_t block_start = 0;               // Stream offset of the open block
+            int div_depth = 0;
+            size_t delivered = 0;                 // Log bytes already handed out
+            bool discard_consumed = false;
+            bool skip_step_notes = false;         // See drop_step_notes()
+            bool flush_lines = false;
+            bool done = false;
+        };
+
+        double elapsed_ms(std::chrono::steady_clock::time_point from,
+                          std::chrono::steady_clock::time_point to)
+        {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        }
+    }
+
     // PIMPL implementation
     class sas_session::impl
     {
@@ -34,7 +349,13 @@ namespace xeus_sas
         impl(const std::string& sas_path);
         ~impl();
 
-        execution_result execute(const std::string& code);
+        void start();
+        std::future<execution_result> submit(const std::string& code,
+                                             const output_callback& on_output,
+                                             const execution_limits& limits,
+                                             bool checkpoint_after);
+        void set_limits(const execution_limits& limits);
+        execution_result execute(const std::string& code, const output_callback& on_output);
         std::string get_version();
         bool is_ready() const;
         void shutdown();
@@ -42,16 +363,147 @@ namespace xeus_sas
         void restart();
         std::string get_macro(const std::string& name);
         void set_macro(const std::string& name, const std::string& value);
+        void set_checkpoint_dir(const std::string& directory, bool restore_existing);
+        bool checkpoint();
+        bool take_due_checkpoint();
+        bool has_checkpoint() const;
 
     private:
-        std::string m_sas_path;
-        bool m_initialized;
-        pid_t m_sas_pid;
-        FILE* m_sas_stdin;
-        FILE* m_sas_stdout;
-        FILE* m_sas_stderr;
+        // Progress of the output reader for one execution
+        enum class read_state
+        {
+            running,    // SAS is still executing the submitted code
+            draining,   // One stream delivered its sentinel, waiting for the other
+            complete,   // Both streams delivered their sentinel
+            aborted     // Interrupted, timed out, or SAS closed its output
+        };
 
+        // Code block written to SAS whose output has not been collected yet
+        struct submission
+        {
+            std::string nonce;                    // Frames this execution's output
+            bool user_manages_ods;
+            bool compact_markup = false;          // Written by tagsets.xeus_sas, not ODS HTML5
+            bool continued = false;               // Runs in the ODS destination the previous block left open
+            output_callback on_output;
+            execution_limits limits;
+            std::string abort_reason;             // Set when the watchdog gives up
+            bool internal = false;                // Kernel housekeeping, not a user cell
+            bool checkpoint_after = false;        // Checkpoint once this cell succeeds
+            std::promise<execution_result> promise;
+        };
+
+        std::string m_sas_path;
+        std::unique_ptr<scratch_directory> m_scratch; // Temporary files and SAS WORK
+        std::vector<std::string> m_sas_options; // From the launch profile (see launch_profile.hpp)
+        std::string m_broker_socket;            // Lease processes from xsas-broker (XEUS_SAS_BROKER)
+        std::atomic<bool> m_initialized;
+        std::future<void> m_startup;            // Background initialize_session()
+        std::mutex m_submit_mutex;              // Writes to SAS stdin, restart
+        std::unique_ptr<sas_process> m_process;
+        event_poller m_poller;
+        std::unique_ptr<html_pipeline> m_html;  // Cleans output blocks while SAS runs
+
+        // Custom ODS tagset (XEUS_SAS_ODS_TAGSET), compiled into each SAS
+        // process before its first cell. Empty source = ODS HTML5.
+        std::string m_tagset_code;
+        pid_t m_tagset_pid;                     // Process the tagset is compiled in
+
+        // Persistent ODS (XEUS_SAS_PERSISTENT_ODS): the internal destination
+        // is opened once and left open between cells. Guarded by
+        // m_submit_mutex except m_ods_resync, which the reader sets.
+        bool m_persistent_ods;
+        pid_t m_ods_pid;                        // Process with the destination open, 0 = none
+        bool m_ods_compact;                     // The open destination is the tagset's
+        std::atomic<bool> m_ods_resync;         // An abort put the streams out of step
+        std::atomic<bool> m_interrupt_requested;
+        std::atomic<bool> m_needs_restart;      // Process out of step after a watchdog abort
+        execution_limits m_limits;              // Session defaults, guarded by m_submit_mutex
+
+        // WORK and macro checkpoints (see work_checkpoint.hpp), guarded by
+        // m_submit_mutex. Empty directory = disabled.
+        std::string m_checkpoint_dir;
+        bool m_checkpoint_after_cells;          // XEUS_SAS_CHECKPOINT=cell
+        std::atomic<bool> m_checkpoint_due;     // A cell succeeded since the last checkpoint
+        bool m_restore_pending;                 // New process, checkpoint not replayed yet
+
+        // Idle hibernation: after m_idle_timeout without executions, the
+        // session state is saved under <checkpoint dir>/hibernate and SAS
+        // is ended; the next execution starts a process and restores it.
+        // Zero timeout = disabled.
+        std::chrono::milliseconds m_idle_timeout;
+        bool m_hibernated;                      // Guarded by m_submit_mutex
+        std::string m_resume_notice;            // Reported to the next submit()
+        std::mutex m_idle_mutex;
+        std::condition_variable m_idle_changed;
+        std::chrono::steady_clock::time_point m_last_activity;
+        bool m_idle_stopping;
+        std::thread m_idle_timer;
+
+        // Pipelined submissions, oldest first. The reader thread collects
+        // their output in order while later blocks are already queued in SAS.
+        std::mutex m_queue_mutex;
+        std::condition_variable m_queue_changed;
+        std::deque<std::unique_ptr<submission>> m_in_flight;
+        bool m_reader_stopping;
+        std::thread m_reader;
+        std::deque<std::string> m_input;        // Code not yet written to SAS stdin
+        size_t m_input_offset;                  // Bytes of m_input.front() already written
+        std::string m_stdout_carry;             // Output read past the last sentinel
+        std::string m_stderr_carry;
+        std::string m_listing_carry;
+
+        // Warm standby processes, spawned and past their banner, ready to be
+        // swapped in by restart()
+        size_t m_standby_size;
+        size_t m_standby_pending;
+        std::mutex m_standby_mutex;
+        std::deque<std::unique_ptr<sas_process>> m_standby;
+        std::vector<std::future<void>> m_background;   // Refills and reaps
+
+        std::future<execution_result> enqueue(const std::string& code,
+                                              const output_callback& on_output,
+                                              const execution_limits& limits,
+                                              bool internal,
+                                              bool checkpoint_after);
+        void prepare_process();
+        void compile_tagset();
+        execution_result run_internal(const std::string& code);
+        bool take_checkpoint(const std::string& directory, bool with_settings);
+        bool restore_checkpoint(const std::string& directory, bool with_settings);
+        std::string hibernation_dir() const;
+        void note_activity();
+        void idle_loop();
+        void stop_idle_timer();
+        void hibernate();
+        void resume();
         void initialize_session();
+        void replace_process();
+        void wait_for_startup();
+        std::unique_ptr<sas_process> start_process();
+        std::unique_ptr<sas_process> take_standby();
+        void refill_standby();
+        void reap_in_background(std::unique_ptr<sas_process> process);
+        void prune_background();
+        void reader_loop();
+        void stop_reader();
+        void wait_until_idle();
+        execution_result collect(submission& sub, read_state& outcome);
+        bool write_input(int fd);
+        void discard_input();
+        read_state read_until_sentinels(submission& sub,
+                                        output_stream& out,
+                                        output_stream& log,
+                                        output_stream& listing,
+                                        execution_result& result);
+        void deliver_output(const submission& sub,
+                            output_stream& out,
+                            output_stream& log,
+                            execution_result& result,
+                            bool wait_for_html = false);
+        void deliver_html(std::string html,
+                          const output_callback& on_output,
+                          execution_result& result);
         std::string find_sas_executable(const std::string& path_hint);
         std::string run_sas_batch(const std::string& code);
     };
@@ -59,25 +511,164 @@ namespace xeus_sas
     sas_session::impl::impl(const std::string& sas_path)
         : m_sas_path(sas_path)
         , m_initialized(false)
-        , m_sas_pid(-1)
-        , m_sas_stdin(nullptr)
-        , m_sas_stdout(nullptr)
-        , m_sas_stderr(nullptr)
+        , m_tagset_pid(0)
+        , m_persistent_ods(false)
+        , m_ods_pid(0)
+        , m_ods_compact(false)
+        , m_ods_resync(false)
+        , m_interrupt_requested(false)
+        , m_needs_restart(false)
+        , m_checkpoint_after_cells(false)
+        , m_checkpoint_due(false)
+        , m_restore_pending(false)
+        , m_idle_timeout(0)
+        , m_hibernated(false)
+        , m_last_activity(std::chrono::steady_clock::now())
+        , m_idle_stopping(false)
+        , m_reader_stopping(false)
+        , m_input_offset(0)
+        , m_standby_size(0)
+        , m_standby_pending(0)
     {
+        // With a broker, SAS processes are leased instead of spawned here
+        const char* broker_env = std::getenv("XEUS_SAS_BROKER");
+        if (broker_env && *broker_env)
+        {
+            m_broker_socket = broker_env;
+            std::cout << "Using SAS broker: " << m_broker_socket << std::endl;
+        }
+
         // Find SAS executable
         if (m_sas_path.empty())
         {
             m_sas_path = find_sas_executable("");
         }
 
-        if (m_sas_path.empty())
+        if (m_sas_path.empty() && m_broker_socket.empty())
         {
             throw std::runtime_error(
                 "SAS executable not found. Please set SAS_PATH environment variable."
             );
         }
 
-        std::cout << "Using SAS: " << m_sas_path << std::endl;
+        if (!m_sas_path.empty())
+        {
+            std::cout << "Using SAS: " << m_sas_path << std::endl;
+        }
+
+        // Private scratch space for temporary files and, unless the launch
+        // profile names another directory, the WORK libraries of SAS
+        m_scratch = std::make_unique<scratch_directory>();
+        std::cout << "Scratch directory: " << m_scratch->path()
+                  << (m_scratch->on_tmpfs() ? " (tmpfs)" : "") << std::endl;
+
+        // Memory and CPU options for this host; leased processes were
+        // started with the broker's
+        if (m_broker_socket.empty())
+        {
+            launch_profile profile = resolve_launch_profile();
+            if (profile.work.empty())
+            {
+                profile.work = m_scratch->work_dir();
+            }
+            m_sas_options = launch_options(profile);
+            std::string joined;
+            for (const auto& option : m_sas_options)
+            {
+                joined += " " + option;
+            }
+            std::cout << "SAS launch options:" << (joined.empty() ? " (none)" : joined) << std::endl;
+        }
+
+        // Output blocks are cleaned on these workers while SAS produces the
+        // next ones; a finished block wakes the output reader to publish it
+        size_t html_workers = html_pipeline::default_workers();
+        m_html = std::make_unique<html_pipeline>(html_workers, [this] { m_poller.wake(); });
+        std::cout << "HTML post-processing workers: " << html_workers << std::endl;
+
+        // ODS tagset writing compact markup instead of ODS HTML5: "1" for
+        // the one installed with the kernel spec, or the path of another
+        const char* tagset_env = std::getenv("XEUS_SAS_ODS_TAGSET");
+        if (tagset_env && *tagset_env && std::string(tagset_env) != "0")
+        {
+            std::string tagset_path = std::string(tagset_env) == "1"
+                ? std::string(kernelspec_dir) + "/xeus_sas_tagset.sas"
+                : std::string(tagset_env);
+            std::ifstream tagset_file(tagset_path);
+            std::stringstream tagset_code;
+            tagset_code << tagset_file.rdbuf();
+            m_tagset_code = tagset_code.str();
+            if (m_tagset_code.empty())
+            {
+                std::cerr << "Cannot read ODS tagset " << tagset_path << ", using ODS HTML5" << std::endl;
+            }
+            else
+            {
+                std::cout << "ODS tagset: " << tagset_path << std::endl;
+            }
+        }
+
+        // Keep the internal ODS destination open across cells
+        const char* persistent_env = std::getenv("XEUS_SAS_PERSISTENT_ODS");
+        m_persistent_ods = persistent_env && std::string(persistent_env) == "1";
+
+        // Number of warm standby processes kept for restart. Off unless
+        // asked for: each one is another SAS process (memory, licence seat)
+        // per session. The broker keeps warm processes itself.
+        const char* standby_env = std::getenv("XEUS_SAS_STANDBY_POOL");
+        if (standby_env)
+        {
+            try
+            {
+                m_standby_size = static_cast<size_t>(std::max(0, std::stoi(standby_env)));
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "Ignoring invalid XEUS_SAS_STANDBY_POOL: " << standby_env << std::endl;
+            }
+        }
+
+        // Checkpoint after every successful cell instead of only on request
+        const char* checkpoint_env = std::getenv("XEUS_SAS_CHECKPOINT");
+        m_checkpoint_after_cells = checkpoint_env && std::string(checkpoint_env) == "cell";
+
+        // End SAS after this long without executions, keeping its state
+        const char* idle_env = std::getenv("XEUS_SAS_IDLE_TIMEOUT");
+        if (idle_env)
+        {
+            try
+            {
+                m_idle_timeout = parse_duration(idle_env);
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "Ignoring invalid XEUS_SAS_IDLE_TIMEOUT: " << idle_env << std::endl;
+            }
+        }
+
+        // Watchdog limits for every cell of this session, all off unless
+        // configured: a step waiting on a database server can look hung
+        // for longer than any default would allow
+        const std::pair<const char*, std::chrono::milliseconds*> limit_envs[] = {
+            {"XEUS_SAS_SOFT_DEADLINE", &m_limits.soft_deadline},
+            {"XEUS_SAS_HARD_DEADLINE", &m_limits.hard_deadline},
+            {"XEUS_SAS_HANG_TIMEOUT", &m_limits.hang_timeout}
+        };
+        for (const auto& entry : limit_envs)
+        {
+            const char* value = std::getenv(entry.first);
+            if (value)
+            {
+                try
+                {
+                    *entry.second = parse_duration(value);
+                }
+                catch (const std::exception&)
+                {
+                    std::cerr << "Ignoring invalid " << entry.first << ": " << value << std::endl;
+                }
+            }
+        }
     }
 
     sas_session::impl::~impl()
@@ -126,103 +717,310 @@ namespace xeus_sas
             return;
 
         std::cout << "Initializing persistent SAS session..." << std::endl;
+        m_scratch->ensure();
 
 #ifndef _WIN32
-        // Create pipes for stdin, stdout, and stderr
-        int stdin_pipe[2];
-        int stdout_pipe[2];
-        int stderr_pipe[2];
-
-        if (pipe(stdin_pipe) != 0 || pipe(stdout_pipe) != 0 || pipe(stderr_pipe) != 0)
-        {
-            throw std::runtime_error("Failed to create pipes for SAS communication");
-        }
-
-        // Fork and exec SAS
-        m_sas_pid = fork();
-
-        if (m_sas_pid == 0)
-        {
-            // Child process - redirect stdin/stdout/stderr and exec SAS
-            dup2(stdin_pipe[0], STDIN_FILENO);
-            dup2(stdout_pipe[1], STDOUT_FILENO);
-            dup2(stderr_pipe[1], STDERR_FILENO);
-
-            close(stdin_pipe[0]);
-            close(stdin_pipe[1]);
-            close(stdout_pipe[0]);
-            close(stdout_pipe[1]);
-            close(stderr_pipe[0]);
-            close(stderr_pipe[1]);
-
-            // Start SAS in interactive mode
-            // -nodms: no display manager
-            // -rsasuser: reuse sasuser library (faster startup)
-            // -noovp: no OVP processing
-            // -nosyntaxcheck: no pre-execution syntax check (faster execution)
-            // -nonews: suppress startup news
-            // -noaltlog: no alternate log
-            // -noaltprint: no alternate print
-            // -stdio: use stdin/stdout for I/O
-            execlp(m_sas_path.c_str(), m_sas_path.c_str(),
-                   "-nodms", "-rsasuser", "-noovp", "-nosyntaxcheck",
-                   "-nonews", "-noaltlog", "-noaltprint", "-stdio", nullptr);
-
-            // If exec fails
-            std::cerr << "Failed to execute SAS: " << m_sas_path << std::endl;
-            exit(1);
-        }
-        else if (m_sas_pid > 0)
-        {
-            // Parent process - setup file streams
-            close(stdin_pipe[0]);
-            close(stdout_pipe[1]);
-            close(stderr_pipe[1]);
-
-            m_sas_stdin = fdopen(stdin_pipe[1], "w");
-            m_sas_stdout = fdopen(stdout_pipe[0], "r");
-            m_sas_stderr = fdopen(stderr_pipe[0], "r");
-
-            if (!m_sas_stdin || !m_sas_stdout || !m_sas_stderr)
+        m_process = take_standby();
+        if (!m_process)
+        {
+            m_process = start_process();
+        }
+
+        m_initialized = true;
+        std::cout << "Persistent SAS session initialized (PID: " << m_process->pid() << ")" << std::endl;
+
+        refill_standby();
+
+        if (m_idle_timeout.count() > 0 && !m_idle_timer.joinable())
+        {
+            note_activity();
+            m_idle_stopping = false;
+            m_idle_timer = std::thread(&impl::idle_loop, this);
+        }
+#else
+        throw std::runtime_error("Windows not yet supported for persistent sessions");
+#endif
+    }
+
+    void sas_session::impl::replace_process()
+    {
+        discard_input();
+        m_stdout_carry.clear();
+        m_stderr_carry.clear();
+        m_listing_carry.clear();
+
+        // Swap in a warm standby if one is ready; the old process is ended
+        // and reaped in the background so the caller does not wait on it
+        auto replacement = take_standby();
+        if (!replacement)
+        {
+            std::cerr << "No standby SAS process ready, starting one" << std::endl;
+            replacement = start_process();
+        }
+
+        if (m_process)
+        {
+            reap_in_background(std::move(m_process));
+        }
+        m_process = std::move(replacement);
+        std::cerr << "Switched to SAS process (PID: " << m_process->pid() << ")" << std::endl;
+
+        // The new process starts from an empty WORK; replay the last
+        // checkpoint before the next cell. State saved by hibernation is
+        // newer than the checkpoint, but a restart goes back to the latter.
+        if (m_hibernated)
+        {
+            m_hibernated = false;
+            remove_tree(hibernation_dir());
+        }
+        m_checkpoint_due = false;
+        m_restore_pending = has_checkpoint();
+
+        refill_standby();
+    }
+
+    void sas_session::impl::start()
+    {
+        if (m_initialized || m_startup.valid())
+            return;
+
+        std::cout << "Starting SAS in the background..." << std::endl;
+        m_startup = std::async(std::launch::async, [this]()
+        {
+            initialize_session();
+        });
+    }
+
+    void sas_session::impl::wait_for_startup()
+    {
+        // Rethrows a startup failure once; the next call starts SAS in the
+        // foreground instead
+        if (m_startup.valid())
+        {
+            auto startup = std::move(m_startup);
+            startup.get();
+        }
+    }
+
+    std::unique_ptr<sas_process> sas_session::impl::start_process()
+    {
+        // SAS prints its banner and loads SASUSER before it reads any code;
+        // wait for that here so callers get a process that answers at once
+        auto started_at = std::chrono::steady_clock::now();
+        auto process = m_broker_socket.empty() ? sas_process::spawn(m_sas_path, m_sas_options)
+                                               : sas_process::lease(m_broker_socket);
+        process->wait_until_ready(std::chrono::seconds(60));
+        std::cerr << "SAS process ready (PID: " << process->pid() << ") after "
+                  << elapsed_ms(started_at, std::chrono::steady_clock::now()) << " ms" << std::endl;
+        return process;
+    }
+
+    std::unique_ptr<sas_process> sas_session::impl::take_standby()
+    {
+        std::lock_guard<std::mutex> lock(m_standby_mutex);
+        if (m_standby.empty())
+        {
+            return nullptr;
+        }
+
+        auto process = std::move(m_standby.front());
+        m_standby.pop_front();
+        return process;
+    }
+
+    void sas_session::impl::refill_standby()
+    {
+        prune_background();
+
+        size_t missing = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_standby_mutex);
+            size_t have = m_standby.size() + m_standby_pending;
+            missing = (have < m_standby_size) ? m_standby_size - have : 0;
+            m_standby_pending += missing;
+        }
+
+        for (size_t i = 0; i < missing; ++i)
+        {
+            m_background.push_back(std::async(std::launch::async, [this]()
             {
-                throw std::runtime_error("Failed to create file streams for SAS communication");
-            }
+                std::unique_ptr<sas_process> process;
+                try
+                {
+                    process = start_process();
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Failed to start standby SAS process: " << e.what() << std::endl;
+                }
 
-            // Set stdin to line buffering for immediate writes
-            setvbuf(m_sas_stdin, nullptr, _IOLBF, 0);
-            // CRITICAL: Set stdout and stderr to unbuffered since we use read() on their fds
-            setvbuf(m_sas_stdout, nullptr, _IONBF, 0);
-            setvbuf(m_sas_stderr, nullptr, _IONBF, 0);
+                std::lock_guard<std::mutex> lock(m_standby_mutex);
+                --m_standby_pending;
+                if (process)
+                {
+                    m_standby.push_back(std::move(process));
+                }
+            }));
+        }
+    }
 
-            // Note: SAS outputs startup messages (copyright, version, etc.) when started
-            // with -stdio. These will appear in the first execution's output.
-            // This is acceptable behavior - the important part is that subsequent
-            // executions don't restart SAS (which would show these messages again).
+    void sas_session::impl::reap_in_background(std::unique_ptr<sas_process> process)
+    {
+        // terminate() blocks until SAS has exited (up to twice the shutdown
+        // grace); keep that off the request path
+        prune_background();
+        std::shared_ptr<sas_process> owned(std::move(process));
+        m_background.push_back(std::async(std::launch::async, [owned]()
+        {
+            owned->terminate();
+        }));
+    }
+
+    void sas_session::impl::prune_background()
+    {
+        m_background.erase(
+            std::remove_if(m_background.begin(), m_background.end(),
+                [](const std::future<void>& task)
+                {
+                    return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                }),
+            m_background.end());
+    }
+
+    execution_result sas_session::impl::execute(const std::string& code,
+                                                const output_callback& on_output)
+    {
+        return submit(code, on_output, execution_limits(), false).get();
+    }
+
+    void sas_session::impl::set_limits(const execution_limits& limits)
+    {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        m_limits = limits;
+    }
+
+    std::future<execution_result> sas_session::impl::submit(const std::string& code,
+                                                            const output_callback& on_output,
+                                                            const execution_limits& limits,
+                                                            bool checkpoint_after)
+    {
+        // Writes from different threads (e.g. inspection while cells are
+        // queued) must not interleave
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+
+#ifndef _WIN32
+        prepare_process();
 
-            m_initialized = true;
-            std::cout << "Persistent SAS session initialized (PID: " << m_sas_pid << ")" << std::endl;
+        // Take the checkpoint due after a successful cell before SAS moves
+        // on to this one
+        if (m_checkpoint_due.exchange(false))
+        {
+            wait_until_idle();
+            take_checkpoint(m_checkpoint_dir, false);
         }
-        else
+
+        if (!m_resume_notice.empty())
         {
-            throw std::runtime_error("Failed to fork process for SAS");
+            std::cerr << m_resume_notice;
+            if (on_output)
+            {
+                on_output({output_kind::notice, m_resume_notice});
+            }
+            m_resume_notice.clear();
         }
+
+        return enqueue(code, on_output, limits, false, checkpoint_after);
 #else
-        throw std::runtime_error("Windows not yet supported for persistent sessions");
+        // Fallback to batch mode on Windows
+        std::promise<execution_result> done;
+        done.set_value(parse_execution_output(run_sas_batch(code)));
+        return done.get_future();
 #endif
     }
 
-    execution_result sas_session::impl::execute(const std::string& code)
+#ifndef _WIN32
+    void sas_session::impl::prepare_process()
     {
-        // Initialize persistent session if not already done
+        // Wait for a background start, or initialize the persistent session
+        // now if there was none
+        wait_for_startup();
         if (!m_initialized)
         {
             initialize_session();
         }
 
-#ifndef _WIN32
-        // Generate unique marker for this execution
-        static int exec_counter = 0;
-        std::string marker = "XEUS_SAS_END_" + std::to_string(++exec_counter);
+        m_resume_notice.clear();
+        if (m_hibernated)
+        {
+            resume();
+        }
+        // After the watchdog gave up on a block, SAS may still be running it
+        // and its output would be read as the next block's; start clean.
+        // The same applies after SAS died in the middle of a block.
+        else if (m_needs_restart.exchange(false))
+        {
+            std::cerr << "Replacing SAS process after aborted execution" << std::endl;
+            wait_until_idle();
+            replace_process();
+        }
+        else
+        {
+            // SAS may also have died between cells (e.g. OOM killer); the
+            // reader only checks while it has work, so check here when idle
+            bool exited;
+            {
+                std::lock_guard<std::mutex> queue_lock(m_queue_mutex);
+                exited = m_in_flight.empty() && m_process->has_exited();
+            }
+            if (exited)
+            {
+                std::cerr << "SAS process " << m_process->exit_description()
+                          << " while idle; starting a new one" << std::endl;
+                replace_process();
+            }
+        }
+
+        // Bring back the state of the last checkpoint into a new process
+        if (m_restore_pending)
+        {
+            m_restore_pending = false;
+            wait_until_idle();
+            restore_checkpoint(m_checkpoint_dir, false);
+        }
+
+        if (!m_tagset_code.empty() && m_tagset_pid != m_process->pid())
+        {
+            compile_tagset();
+        }
+    }
+
+    void sas_session::impl::compile_tagset()
+    {
+        // Once per process; a failure falls back to ODS HTML5 for the rest
+        // of the session rather than failing every cell
+        wait_until_idle();
+        auto result = run_internal(m_tagset_code);
+        if (result.is_error)
+        {
+            std::cerr << "Compiling the ODS tagset failed, using ODS HTML5: "
+                      << result.error_message << std::endl;
+            m_tagset_code.clear();
+            return;
+        }
+        m_tagset_pid = m_process->pid();
+        std::cerr << "Compiled ODS tagset in SAS process " << m_tagset_pid << std::endl;
+    }
+
+    std::future<execution_result> sas_session::impl::enqueue(const std::string& code,
+                                                             const output_callback& on_output,
+                                                             const execution_limits& limits,
+                                                             bool internal,
+                                                             bool checkpoint_after)
+    {
+        // A fresh random nonce frames this execution on both streams, so no
+        // user output can be mistaken for a sentinel
+        std::string nonce = generate_execution_marker();
+        frame_markers markers(nonce);
 
         // Wrap code with ODS HTML5 commands for rich output
         // Following sas_kernel's approach:
@@ -246,757 +1044,749 @@ namespace xeus_sas
                                   code_lower.find("ods html") != std::string::npos ||
                                   code_lower.find("ods pdf") != std::string::npos ||
                                   code_lower.find("ods rtf") != std::string::npos);
-
+        bool compact_markup = !user_manages_ods && m_process && m_tagset_pid == m_process->pid();
+
+        // The internal destination: ODS HTML5, or the kernel's tagset
+        std::string ods_open = compact_markup
+            ? "ods markup (id=xeus_sas_internal) tagset=tagsets.xeus_sas body=stdout gpath=\"" +
+                  m_scratch->path() + "\";\n"
+            : "ods html5 (id=xeus_sas_internal) body=stdout(no_top_matter no_bottom_matter) style=" +
+                  ods_style + ";\n";
+        ods_open = "ods listing close;\n" + ods_open + "ods graphics on / outputfmt=png;\n";
+
+        // With persistent ODS, cells that leave ODS alone run in a destination
+        // that stays open, and the previous cell's end sentinel is where this
+        // one begins. Cells that touch ODS, a change of destination, or
+        // streams out of step after an abort go back to the full wrapping.
+        bool persistent = m_persistent_ods && !touches_ods(code_lower);
+        bool ods_open_here = m_process && m_ods_pid == m_process->pid();
+        bool resync = m_ods_resync.exchange(false);
+        bool continued = persistent && ods_open_here && !resync && m_ods_compact == compact_markup;
+
+        std::string begin_marker = frame_markers::quoted(markers.begin);
+        std::string end_marker = frame_markers::quoted(markers.end);
         std::stringstream wrapped_code;
-        std::string listing_file = "/tmp/xeus_sas_listing_" + std::to_string(exec_counter) + ".lst";
+        if (ods_open_here && !continued)
+        {
+            // Whatever closing flushes comes before the begin sentinels
+            wrapped_code << "ods " << (m_ods_compact ? "markup" : "html5") << " (id=xeus_sas_internal) close;\n"
+                         << "ods listing;\n";
+            m_ods_pid = 0;
+        }
+
+        // Begin sentinels on both streams: everything SAS writes before them
+        // (late output of the previous block) is not part of this execution.
+        // A continued cell gets them from a single step, like its end.
+        if (continued)
+        {
+            wrapped_code << "data _null_; file stdout; put \"" << begin_marker << "\"; putlog \"" << begin_marker
+                         << "\"; run;\n";
+        }
+        else
+        {
+            wrapped_code << "data _null_; file stdout; put \"" << begin_marker << "\"; run;\n"
+                         << "%put " << begin_marker << ";\n";
+        }
+
         if (user_manages_ods)
         {
             // User is managing ODS destinations - run code as-is
-            // Capture any listing output to a file by setting PROC PRINTTO
+            // Capture any listing output through the listing pipe (fd 3),
+            // framed by its own sentinels
             std::cerr << "User manages ODS destinations - using listing mode" << std::endl;
-            wrapped_code << "proc printto print='" << listing_file << "' new; run;\n"
+            std::string listing_path = "/dev/fd/" + std::to_string(sas_process::listing_fd_number);
+            wrapped_code << "data _null_; file '" << listing_path << "'; put \"" << begin_marker << "\"; run;\n"
+                         << "proc printto print='" << listing_path << "'; run;\n"
                          << code << "\n"
                          << "proc printto; run;\n"
+                         << "data _null_; file '" << listing_path << "'; put \"" << end_marker << "\"; run;\n"
                          << "* Force flush of all output before marker;\n"
                          << "DATA _null_; run;\n";
         }
+        else if (persistent)
+        {
+            if (!continued)
+            {
+                wrapped_code << ods_open;
+                m_ods_pid = m_process->pid();
+                m_ods_compact = compact_markup;
+            }
+            wrapped_code << code << "\n";
+        }
         else
         {
-            // Default: wrap with HTML5 for rich output
-            wrapped_code << "ods listing close;\n"
-                         << "ods html5 (id=xeus_sas_internal) body=stdout(no_top_matter no_bottom_matter) style=" << ods_style << ";\n"
-                         << "ods graphics on / outputfmt=png;\n"
+            // Default: wrap with HTML5 (or the tagset) for rich output; graphs
+            // of the tagset are written to the scratch directory
+            wrapped_code << ods_open
                          << "\n"
                          << code << "\n"
                          << "\n"
-                         << "ods html5 (id=xeus_sas_internal) close;\n"
+                         << "ods " << (compact_markup ? "markup" : "html5") << " (id=xeus_sas_internal) close;\n"
                          << "ods listing;\n"
                          << "* Force flush of all output before marker;\n"
                          << "DATA _null_; run;\n";
         }
 
-        // Send wrapped code to SAS
-        fprintf(m_sas_stdin, "%s\n", wrapped_code.str().c_str());
-
-        // Send marker to stderr (log stream) to detect end of output
-        // Note: We add a DATA _null_; RUN; after the marker to force SAS to flush output
-        fprintf(m_sas_stdin, "%%put %s;\n", marker.c_str());
-        fprintf(m_sas_stdin, "DATA _null_; run;\n");
-        fflush(m_sas_stdin);
-
-        // Read both stdout (HTML) and stderr (log) until we see the marker
-        // We need to read both streams to avoid deadlock
-        // IMPORTANT: We must wait for BOTH conditions:
-        // 1. Marker found in stderr (log)
-        // 2. Complete HTML document received (if HTML is present)
-        std::string html_output;
-        std::string log_output;
-        char buffer[8192];  // Larger buffer for better performance
-        bool found_marker = false;
-        bool found_html_end = false;
-        bool has_html_start = false;
-
-        // Set stderr to non-blocking mode for polling
-        int stderr_fd = fileno(m_sas_stderr);
-        int stdout_fd = fileno(m_sas_stdout);
-        int stderr_flags = fcntl(stderr_fd, F_GETFL, 0);
-        int stdout_flags = fcntl(stdout_fd, F_GETFL, 0);
-        fcntl(stderr_fd, F_SETFL, stderr_flags | O_NONBLOCK);
-        fcntl(stdout_fd, F_SETFL, stdout_flags | O_NONBLOCK);
-
-        // Poll both streams until we find the marker in stderr
-        struct pollfd fds[2];
-        fds[0].fd = stdout_fd;
-        fds[0].events = POLLIN;
-        fds[1].fd = stderr_fd;
-        fds[1].events = POLLIN;
-
-        // Continue reading until we have both marker AND complete HTML
-        int timeout_count = 0;
-        int consecutive_empty_reads = 0;
-        const int max_timeouts = 30;  // Allow up to 30 seconds total
-        const int max_empty_reads = 5;  // If we get 5 consecutive empty reads, we're probably done
+        if (persistent)
+        {
+            // A single step ends the cell on both streams. Starting it ends the
+            // user's last step, whose ODS output is then already written; its
+            // own notes follow the log sentinel, before the next begin sentinel.
+            wrapped_code << "\n"
+                         << "data _null_; file stdout; put \"" << end_marker << "\"; putlog \"" << end_marker
+                         << "\"; run;\n";
+        }
+        else
+        {
+            // End sentinels: one on stdout after all ODS output, one in the log.
+            // The trailing DATA _null_; RUN; forces SAS to flush the log.
+            wrapped_code << "\n"
+                         << "data _null_; file stdout; put \"" << end_marker << "\"; run;\n"
+                         << "%put " << end_marker << ";\n"
+                         << "DATA _null_; run;\n";
+        }
 
-        while (!found_marker || (has_html_start && !found_html_end))
+        // Queue for the reader; the caller gets the result through the future
+        auto sub = std::make_unique<submission>();
+        sub->nonce = nonce;
+        sub->user_manages_ods = user_manages_ods;
+        sub->compact_markup = compact_markup;
+        sub->continued = continued;
+        sub->on_output = on_output;
+        sub->limits = m_limits.merged(limits);
+        sub->internal = internal;
+        sub->checkpoint_after = checkpoint_after;
+        auto result = sub->promise.get_future();
         {
-            int poll_result = poll(fds, 2, 1000); // 1 second timeout
-            if (poll_result < 0)
+            std::lock_guard<std::mutex> queue_lock(m_queue_mutex);
+            if (m_in_flight.empty())
             {
-                std::cerr << "Poll error in SAS output reading" << std::endl;
-                break; // Error
+                // A stale interrupt must not abort this submission
+                m_interrupt_requested = false;
             }
-            else if (poll_result == 0)
+            m_in_flight.push_back(std::move(sub));
+            note_activity();
+
+            // Written by the reader thread as SAS drains its stdin
+            m_input.push_back(wrapped_code.str());
+            if (!m_reader.joinable())
             {
-                // No data available right now
-                timeout_count++;
-                consecutive_empty_reads++;
+                m_reader_stopping = false;
+                m_reader = std::thread(&impl::reader_loop, this);
+            }
+        }
+        m_queue_changed.notify_all();
+        m_poller.wake();
 
-                // If we have the marker and either no HTML or found HTML end, we can stop
-                if (found_marker && (!has_html_start || found_html_end))
+        return result;
+    }
+#endif
+
+    void sas_session::impl::reader_loop()
+    {
+        while (true)
+        {
+            submission* sub = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_queue_mutex);
+                m_queue_changed.wait(lock, [this]() { return m_reader_stopping || !m_in_flight.empty(); });
+                if (m_in_flight.empty())
                 {
-                    break;
+                    return;
                 }
+                sub = m_in_flight.front().get();
+            }
 
-                // If we've had too many consecutive empty reads after finding marker, give up
-                if (found_marker && consecutive_empty_reads >= max_empty_reads)
+            read_state outcome = read_state::aborted;
+            execution_result result;
+            if (!m_reader_stopping)
+            {
+                try
                 {
-                    std::cerr << "WARNING: No more data after " << consecutive_empty_reads << " empty reads" << std::endl;
-                    std::cerr << "  Marker found: " << found_marker << std::endl;
-                    std::cerr << "  HTML start found: " << has_html_start << std::endl;
-                    std::cerr << "  HTML end found: " << found_html_end << std::endl;
-                    std::cerr << "  HTML length so far: " << html_output.length() << std::endl;
-                    break;
+                    result = collect(*sub, outcome);
                 }
-
-                if (timeout_count >= max_timeouts)
+                catch (const std::exception& e)
                 {
-                    std::cerr << "WARNING: Timeout waiting for complete SAS output" << std::endl;
-                    std::cerr << "  Marker found: " << found_marker << std::endl;
-                    std::cerr << "  HTML start found: " << has_html_start << std::endl;
-                    std::cerr << "  HTML end found: " << found_html_end << std::endl;
-                    break;
+                    std::cerr << "Output reader failed: " << e.what() << std::endl;
+                    result.is_error = true;
+                    result.error_code = 1;
+                    result.error_message = e.what();
                 }
-                continue; // Timeout, try again
             }
-
-            // We got data, reset empty read counter
-            consecutive_empty_reads = 0;
-
-            // Read from stdout (HTML)
-            if (fds[0].revents & POLLIN)
+            else
             {
-                ssize_t bytes_read = read(stdout_fd, buffer, sizeof(buffer) - 1);
-                if (bytes_read > 0)
-                {
-                    buffer[bytes_read] = '\0';  // Null terminate
-                    html_output.append(buffer, bytes_read);
-
-                    // Check for HTML document markers (full document or fragment)
-                    if (!has_html_start &&
-                        (html_output.find("<!DOCTYPE html>") != std::string::npos ||
-                         html_output.find("<html") != std::string::npos ||
-                         html_output.find("<div") != std::string::npos ||
-                         html_output.find("<table") != std::string::npos))
-                    {
-                        has_html_start = true;
-                    }
-
-                    // Check for HTML end - use rfind to get the LAST occurrence
-                    // For fragments (no_top_matter), we don't need </html>
-                    if (has_html_start && !found_html_end)
-                    {
-                        if (html_output.find("</html>") != std::string::npos ||
-                            html_output.find("</div>") != std::string::npos ||
-                            html_output.find("</table>") != std::string::npos)
-                        {
-                            found_html_end = true;
-                        }
-                    }
-                }
+                result.is_error = true;
+                result.error_code = 1;
+                result.error_message = "SAS session shut down";
             }
 
-            // Read from stderr (log)
-            if (fds[1].revents & POLLIN)
+            std::unique_ptr<submission> finished;
+            std::vector<std::unique_ptr<submission>> dropped;
             {
-                ssize_t bytes_read = read(stderr_fd, buffer, sizeof(buffer) - 1);
-                if (bytes_read > 0)
-                {
-                    buffer[bytes_read] = '\0';  // Null terminate
-                    std::string chunk(buffer, bytes_read);
+                std::lock_guard<std::mutex> lock(m_queue_mutex);
+                finished = std::move(m_in_flight.front());
+                m_in_flight.pop_front();
 
-                    // Check if this chunk contains our marker
-                    if (chunk.find(marker) != std::string::npos)
-                    {
-                        found_marker = true;
-                        // Don't add the marker line to log - split and remove it
-                        size_t marker_pos = chunk.find(marker);
-                        size_t line_start = chunk.rfind('\n', marker_pos);
-                        if (line_start != std::string::npos)
-                        {
-                            log_output += chunk.substr(0, line_start + 1);
-                        }
-                        // Skip the marker line and add anything after
-                        size_t line_end = chunk.find('\n', marker_pos);
-                        if (line_end != std::string::npos && line_end + 1 < chunk.length())
-                        {
-                            log_output += chunk.substr(line_end + 1);
-                        }
-                    }
-                    else
+                // After an abort the streams are out of step with the queue;
+                // everything still in flight is lost with the process
+                if (outcome == read_state::aborted)
+                {
+                    m_ods_resync = true;
+                    m_input.clear();
+                    m_input_offset = 0;
+                    m_stdout_carry.clear();
+                    m_stderr_carry.clear();
+                    m_listing_carry.clear();
+                    for (auto& pending : m_in_flight)
                     {
-                        log_output += chunk;
+                        dropped.push_back(std::move(pending));
                     }
+                    m_in_flight.clear();
                 }
             }
 
-            // Exit if we have marker and either no HTML or complete HTML
-            if (found_marker && (!has_html_start || found_html_end))
+            if ((m_checkpoint_after_cells || finished->checkpoint_after) && !finished->internal &&
+                outcome == read_state::complete && !result.is_error)
             {
-                break;
+                m_checkpoint_due = true;
             }
+            note_activity();
+            finished->promise.set_value(std::move(result));
+            for (auto& pending : dropped)
+            {
+                execution_result skipped;
+                skipped.is_error = true;
+                skipped.error_code = 1;
+                skipped.error_message = m_interrupt_requested ? "Execution interrupted"
+                                      : finished->abort_reason.empty() ? "Execution aborted"
+                                      : "Execution aborted: " + finished->abort_reason;
+                pending->promise.set_value(std::move(skipped));
+            }
+            m_queue_changed.notify_all();
         }
+    }
 
-        // Restore blocking mode
-        fcntl(stderr_fd, F_SETFL, stderr_flags);
-        fcntl(stdout_fd, F_SETFL, stdout_flags);
+    void sas_session::impl::wait_until_idle()
+    {
+        std::unique_lock<std::mutex> lock(m_queue_mutex);
+        m_queue_changed.wait(lock, [this]() { return m_in_flight.empty(); });
+    }
 
-        // Extract clean HTML if present
-        std::string clean_html;
-        bool has_html = false;
+    void sas_session::impl::stop_reader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            m_reader_stopping = true;
+        }
+        m_queue_changed.notify_all();
+        m_poller.wake();
 
-        if (has_html_start)
+        if (m_reader.joinable())
         {
-            // === DEBUG: Log raw HTML output before extraction ===
-            std::cerr << "\n=== SAS_SESSION: RAW HTML OUTPUT DEBUG ===" << std::endl;
-            std::cerr << "Raw HTML output length: " << html_output.length() << std::endl;
-            std::cerr << "First 400 chars: " << html_output.substr(0, std::min<size_t>(400, html_output.length())) << std::endl;
-            if (html_output.length() > 400)
-            {
-                size_t start = html_output.length() > 400 ? html_output.length() - 400 : 0;
-                std::cerr << "Last 400 chars: " << html_output.substr(start) << std::endl;
-            }
-            std::cerr << "==========================================\n" << std::endl;
+            m_reader.join();
+        }
+    }
 
-            // Find HTML document boundaries (support full docs and fragments)
-            size_t html_start = html_output.find("<!DOCTYPE html>");
-            if (html_start == std::string::npos)
+    bool sas_session::impl::write_input(int fd)
+    {
+        // One bounded writev per writable event, so reading is never starved
+        // by a multi-megabyte cell
+        const size_t max_slice = 64 * 1024;
+        const int max_buffers = 16;
+
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+
+        struct iovec buffers[max_buffers];
+        int count = 0;
+        size_t slice = 0;
+        size_t offset = m_input_offset;
+        for (auto it = m_input.begin(); it != m_input.end() && count < max_buffers && slice < max_slice; ++it)
+        {
+            size_t length = std::min(it->size() - offset, max_slice - slice);
+            buffers[count].iov_base = const_cast<char*>(it->data() + offset);
+            buffers[count].iov_len = length;
+            slice += length;
+            ++count;
+            offset = 0;
+        }
+
+        if (count == 0)
+        {
+            return false;
+        }
+
+        ssize_t written = writev(fd, buffers, count);
+        if (written < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
             {
-                html_start = html_output.find("<html");
+                return true;
             }
 
-            // Check for fragment HTML (no_top_matter output)
-            bool is_fragment = false;
-            if (html_start == std::string::npos)
+            // SAS is gone; the readers will see its output close
+            std::cerr << "Failed to write to SAS: " << std::strerror(errno) << std::endl;
+            m_input.clear();
+            m_input_offset = 0;
+            return false;
+        }
+
+        size_t remaining = static_cast<size_t>(written);
+        while (remaining > 0)
+        {
+            size_t left = m_input.front().size() - m_input_offset;
+            if (remaining < left)
             {
-                // Try to find fragment start (<div> or <table>)
-                html_start = html_output.find("<div");
-                if (html_start == std::string::npos)
-                {
-                    html_start = html_output.find("<table");
-                }
-                is_fragment = (html_start != std::string::npos);
+                m_input_offset += remaining;
+                break;
             }
+            remaining -= left;
+            m_input.pop_front();
+            m_input_offset = 0;
+        }
+        return !m_input.empty();
+    }
 
-            size_t html_end = html_output.rfind("</html>");  // Use rfind for LAST occurrence
-            size_t end_offset = 7;  // Length of "</html>"
+    void sas_session::impl::discard_input()
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_input.clear();
+        m_input_offset = 0;
+    }
 
-            // For fragments, look for </div> or </table> instead
-            if (is_fragment || html_end == std::string::npos)
+    execution_result sas_session::impl::collect(submission& sub, read_state& outcome)
+    {
+        const output_callback& on_output = sub.on_output;
+
+        execution_result result;
+        result.has_html = false;
+        frame_markers markers(sub.nonce);
+        output_stream out(markers, true);
+        output_stream log(markers, false);
+        output_stream listing(markers, false);
+
+        // Only listing-mode submissions write to the listing pipe
+        listing.done = !sub.user_manages_ods;
+
+        // The notes of a continued block's begin step follow its log sentinel
+        log.skip_step_notes = sub.continued;
+
+        // When streaming, finished blocks are handed out and dropped right away
+        out.discard_consumed = static_cast<bool>(on_output);
+        outcome = read_until_sentinels(sub, out, log, listing, result);
+        log.drop_step_notes();
+
+        // Framed output that was not cut out as <div> blocks (e.g. a bare
+        // table or a user-managed document) is delivered as a whole once SAS
+        // has finished; the frame already excludes everything foreign to it
+        if (!result.has_html)
+        {
+            std::string remainder = out.data.substr(out.unconsumed());
+            if (remainder.find('<') != std::string::npos)
             {
-                html_end = html_output.rfind("</div>");
-                end_offset = 6;
-                if (html_end == std::string::npos)
-                {
-                    html_end = html_output.rfind("</table>");
-                    end_offset = 8;
-                }
+                deliver_html(sub.compact_markup ? normalize_compact_html(remainder) : clean_ods_html(remainder),
+                             on_output, result);
             }
+        }
+
+        // Fill result with log and listing (HTML was delivered while reading)
+        result.log = std::move(log.data);
+        result.listing = std::move(listing.data);
 
-            std::cerr << "=== SAS_SESSION: HTML EXTRACTION DEBUG ===" << std::endl;
-            std::cerr << "html_start position: " << html_start << std::endl;
-            std::cerr << "html_end position: " << html_end << std::endl;
-            std::cerr << "is_fragment: " << is_fragment << std::endl;
+        // Check for errors in log
+        int error_code = 0;
+        result.is_error = contains_error(result.log, error_code);
+        result.error_code = error_code;
 
-            if (html_start != std::string::npos && html_end != std::string::npos)
+        if (result.is_error)
+        {
+            // Extract error message
+            std::regex error_regex(R"(ERROR:?\s*(.+))");
+            std::smatch match;
+            if (std::regex_search(result.log, match, error_regex))
             {
-                html_end += end_offset;  // Include closing tag
-                clean_html = html_output.substr(html_start, html_end - html_start);
-                has_html = true;
-
-                // Post-process HTML to fix euporie rendering issues
-                // Merge multiple colgroups into one (SAS splits rowheader from data columns)
-                size_t colgroup_pos = 0;
-                int colgroup_count = 0;
-                int total_cols = 0;
-                std::vector<size_t> colgroup_positions;
-
-                // Find all colgroups and count columns
-                while ((colgroup_pos = clean_html.find("<colgroup>", colgroup_pos)) != std::string::npos)
-                {
-                    colgroup_positions.push_back(colgroup_pos);
-                    colgroup_count++;
+                result.error_message = match[1].str();
+            }
+        }
 
-                    // Count cols in this colgroup
-                    size_t colgroup_end = clean_html.find("</colgroup>", colgroup_pos);
-                    size_t search_pos = colgroup_pos;
-                    while ((search_pos = clean_html.find("<col/>", search_pos)) != std::string::npos && search_pos < colgroup_end)
-                    {
-                        total_cols++;
-                        search_pos += 6;
-                    }
+        if (outcome == read_state::aborted && m_interrupt_requested)
+        {
+            result.is_error = true;
+            result.error_code = 1;
+            result.error_message = "Execution interrupted";
+        }
+        else if (!sub.abort_reason.empty())
+        {
+            result.is_error = true;
+            result.error_code = 1;
+            result.error_message = sub.abort_reason;
+        }
 
-                    colgroup_pos = colgroup_end;
-                }
+        // Extract graph files from log (after those of the tagset, if any)
+        for (auto& graph_file : extract_graph_files(result.log))
+        {
+            result.graph_files.push_back(std::move(graph_file));
+        }
 
-                // If we have multiple colgroups, merge them into one
-                if (colgroup_count > 1 && colgroup_positions.size() >= 2)
-                {
-                    std::cerr << "Merging " << colgroup_count << " colgroups with " << total_cols << " total columns" << std::endl;
+        return result;
+    }
 
-                    // Build new single colgroup
-                    std::string new_colgroup = "<colgroup>";
-                    for (int i = 0; i < total_cols; i++)
-                    {
-                        new_colgroup += "<col/>";
-                    }
-                    new_colgroup += "</colgroup>";
+    void sas_session::impl::deliver_html(std::string html,
+                                         const output_callback& on_output,
+                                         execution_result& result)
+    {
+        result.has_html = true;
+        if (on_output)
+        {
+            on_output({output_kind::html, std::move(html)});
+        }
+        else
+        {
+            result.html_output += html;
+        }
+    }
 
-                    // Find the range to replace (first colgroup start to last colgroup end)
-                    size_t first_colgroup = colgroup_positions[0];
-                    size_t last_colgroup_end = clean_html.find("</colgroup>", colgroup_positions.back()) + 11; // +11 for "</colgroup>"
+    void sas_session::impl::deliver_output(const submission& sub,
+                                           output_stream& out,
+                                           output_stream& log,
+                                           execution_result& result,
+                                           bool wait_for_html)
+    {
+        const output_callback& on_output = sub.on_output;
 
-                    // Replace
-                    clean_html = clean_html.substr(0, first_colgroup) + new_colgroup + clean_html.substr(last_colgroup_end);
-                }
+        // Blocks are cleaned on the pipeline's workers while this thread
+        // keeps reading; whatever is ready is published in order
+        for (auto& block : out.blocks)
+        {
+            m_html->push(std::move(block), sub.compact_markup ? normalize_compact_html : clean_ods_html);
+        }
+        out.blocks.clear();
 
-                // Remove "The SAS System" title container (systitleandfootercontainer div)
-                size_t title_pos = 0;
-                while ((title_pos = clean_html.find("systitleandfootercontainer", title_pos)) != std::string::npos)
+        std::string html;
+        while (wait_for_html ? m_html->wait_pop(html) : m_html->pop(html))
+        {
+            // The tagset writes a placeholder for each graph (see
+            // xeus_sas_tagset.sas); in cell values quotes are escaped
+            static const std::string graph_attribute = "data-file=\"";
+            size_t graph = sub.compact_markup ? html.find(graph_attribute) : std::string::npos;
+            if (graph != std::string::npos)
+            {
+                graph += graph_attribute.size();
+                std::string file = html.substr(graph, html.find('"', graph) - graph);
+                if (file.empty() || file[0] != '/')
                 {
-                    // Find the opening <div that contains this class
-                    size_t div_start = clean_html.rfind("<div", title_pos);
-                    if (div_start != std::string::npos)
-                    {
-                        // Find the matching </div>
-                        size_t div_end = clean_html.find("</div>", title_pos);
-                        if (div_end != std::string::npos)
-                        {
-                            clean_html.erase(div_start, div_end + 6 - div_start);
-                            // Search from beginning since we modified the string
-                            title_pos = 0;
-                        }
-                        else
-                        {
-                            title_pos++;
-                        }
-                    }
-                    else
-                    {
-                        title_pos++;
-                    }
+                    file = m_scratch->file(file);
                 }
-
-                // Additional simplification: remove inline styles that might confuse terminal renderers
-                // Remove style attributes from table and other elements
-                size_t style_pos = 0;
-                while ((style_pos = clean_html.find(" style=", style_pos)) != std::string::npos)
+                if (on_output)
                 {
-                    size_t quote_start = clean_html.find("\"", style_pos);
-                    if (quote_start != std::string::npos)
-                    {
-                        size_t quote_end = clean_html.find("\"", quote_start + 1);
-                        if (quote_end != std::string::npos)
-                        {
-                            clean_html.erase(style_pos, quote_end - style_pos + 1);
-                        }
-                        else
-                        {
-                            style_pos++;
-                        }
-                    }
-                    else
-                    {
-                        style_pos++;
-                    }
+                    on_output({output_kind::graph, std::move(file)});
                 }
-
-                // Remove aria-label attributes (accessibility but not needed for terminal)
-                style_pos = 0;
-                while ((style_pos = clean_html.find(" aria-label=", style_pos)) != std::string::npos)
+                else
                 {
-                    size_t quote_start = clean_html.find("\"", style_pos);
-                    if (quote_start != std::string::npos)
-                    {
-                        size_t quote_end = clean_html.find("\"", quote_start + 1);
-                        if (quote_end != std::string::npos)
-                        {
-                            clean_html.erase(style_pos, quote_end - style_pos + 1);
-                        }
-                        else
-                        {
-                            style_pos++;
-                        }
-                    }
-                    else
-                    {
-                        style_pos++;
-                    }
+                    result.graph_files.push_back(std::move(file));
                 }
+            }
+            // Title containers clean up to nothing; don't publish empty output
+            else if (html.find_first_not_of(" \t\r\n") != std::string::npos)
+            {
+                deliver_html(std::move(html), on_output, result);
+            }
+        }
 
-                // CRITICAL FIX: Move thead content to be first row of tbody
-                // Terminal renderers like euporie may treat thead as floating/fixed
-                // This causes misalignment with the table body
-                size_t thead_start = clean_html.find("<thead>");
-                size_t tbody_start = clean_html.find("<tbody>");
-
-                if (thead_start != std::string::npos && tbody_start != std::string::npos)
+        if (on_output)
+        {
+            std::string lines = log.take_lines();
+            if (!lines.empty())
+            {
+                on_output({output_kind::log, lines});
+                for (auto& graph_file : extract_graph_files(lines))
                 {
-                    size_t thead_end = clean_html.find("</thead>", thead_start);
-                    if (thead_end != std::string::npos)
-                    {
-                        // Extract the header row content (between <thead> and </thead>)
-                        size_t content_start = thead_start + 7; // After <thead>
-                        std::string header_content = clean_html.substr(content_start, thead_end - content_start);
+                    on_output({output_kind::graph, std::move(graph_file)});
+                }
+            }
+        }
+    }
 
-                        // Remove the entire <thead>...</thead> section
-                        clean_html.erase(thead_start, thead_end + 8 - thead_start);
+    sas_session::impl::read_state sas_session::impl::read_until_sentinels(
+        submission& sub,
+        output_stream& out,
+        output_stream& log,
+        output_stream& listing,
+        execution_result& result)
+    {
+        // Event-driven reader: sleep until either pipe has data, interrupt()
+        // wakes us or the watchdog is due, and finish the moment both
+        // sentinels have arrived. Both streams must be drained continuously
+        // to avoid a pipe deadlock.
+        using clock = std::chrono::steady_clock;
+        const output_callback& on_output = sub.on_output;
+
+        int stdin_fd = m_process->input_fd();
+        int stdout_fd = m_process->output_fd();
+        int stderr_fd = m_process->log_fd();
+        int listing_fd = m_process->listing_fd();
+        int exit_fd = m_process->exit_fd();
+        int stdout_flags = fcntl(stdout_fd, F_GETFL, 0);
+        int stderr_flags = fcntl(stderr_fd, F_GETFL, 0);
+        fcntl(stdout_fd, F_SETFL, stdout_flags | O_NONBLOCK);
+        fcntl(stderr_fd, F_SETFL, stderr_flags | O_NONBLOCK);
+        fcntl(listing_fd, F_SETFL, fcntl(listing_fd, F_GETFL, 0) | O_NONBLOCK);
+        m_poller.add(stdout_fd, true);
+        m_poller.add(stderr_fd, true);
+        if (exit_fd >= 0)
+        {
+            m_poller.add(exit_fd, true);
+        }
 
-                        // Find tbody again (position changed after erase)
-                        tbody_start = clean_html.find("<tbody>");
-                        if (tbody_start != std::string::npos)
-                        {
-                            // Insert header content right after <tbody>
-                            clean_html.insert(tbody_start + 7, header_content);
-                            std::cerr << "Moved thead content to first row of tbody" << std::endl;
-                        }
-                    }
+        // Output of this block that was read together with the previous one
+        if (!m_stdout_carry.empty())
+        {
+            std::string carried;
+            carried.swap(m_stdout_carry);
+            out.append(carried.data(), carried.size());
+        }
+        if (!m_stderr_carry.empty())
+        {
+            std::string carried;
+            carried.swap(m_stderr_carry);
+            log.append(carried.data(), carried.size());
+        }
+        if (!listing.done)
+        {
+            if (!m_listing_carry.empty())
+            {
+                std::string carried;
+                carried.swap(m_listing_carry);
+                listing.append(carried.data(), carried.size());
+            }
+            if (!listing.done)
+            {
+                m_poller.add(listing_fd, true);
+            }
+        }
+        deliver_output(sub, out, log, result);
+
+        read_state state = (out.done && log.done && listing.done) ? read_state::complete : read_state::running;
+        auto submitted_at = clock::now();
+        auto first_sentinel_at = submitted_at;
+        execution_watchdog watchdog(m_process->pid(), sub.limits, submitted_at);
+
+        // Resource counters of SAS around this block; the end is sampled
+        // when SAS reaches the end sentinel, before it moves on to the next
+        bool peak_reset = reset_peak_rss(m_process->pid());
+        resource_sample start_sample = sample_process(m_process->pid());
+        resource_sample end_sample;
+        std::vector<poll_event> events;
+        char buffer[8192];
+        bool writing = false;
+        bool child_exited = false;
+
+        // Read what is available on one stream, stopping at its end sentinel.
+        // Returns 0 at EOF.
+        auto read_stream = [&](int fd, output_stream& stream) -> ssize_t
+        {
+            ssize_t bytes_read = -1;
+            while (!stream.done && (bytes_read = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                watchdog.note_output(clock::now());
+                stream.append(buffer, static_cast<size_t>(bytes_read));
+            }
+            deliver_output(sub, out, log, result);
+            if (stream.done)
+            {
+                // Later submissions' output stays in the pipe until their turn
+                m_poller.remove(fd);
+            }
+            return stream.done ? -1 : bytes_read;
+        };
+
+        while (state == read_state::running || state == read_state::draining)
+        {
+            // Code still waiting for SAS stdin (this block or later ones) is
+            // written whenever the pipe has room, in the same loop that keeps
+            // stdout and stderr drained
+            bool pending_input;
+            {
+                std::lock_guard<std::mutex> lock(m_queue_mutex);
+                pending_input = !m_input.empty();
+            }
+            if (pending_input != writing)
+            {
+                if (pending_input)
+                {
+                    m_poller.add(stdin_fd, false, true);
+                }
+                else
+                {
+                    m_poller.remove(stdin_fd);
                 }
+                writing = pending_input;
+            }
 
-                // Remove empty caption elements that create extra spacing
-                // But keep captions with actual text content
-                size_t caption_pos = 0;
-                while ((caption_pos = clean_html.find("<caption", caption_pos)) != std::string::npos)
+            auto now = clock::now();
+            watchdog_verdict verdict = watchdog.check(now);
+            if (verdict == watchdog_verdict::soft_deadline)
+            {
+                auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now - submitted_at).count();
+                std::string notice = "Cell has been running for " + std::to_string(seconds) +
+                                     " s (soft deadline); SAS is still making progress\n";
+                std::cerr << notice;
+                if (on_output)
                 {
-                    size_t caption_end = clean_html.find("</caption>", caption_pos);
-                    if (caption_end != std::string::npos)
-                    {
-                        // Find where caption tag ends (could have attributes)
-                        size_t tag_close = clean_html.find(">", caption_pos);
-                        if (tag_close != std::string::npos && tag_close < caption_end)
-                        {
-                            // Extract text between <caption...> and </caption>
-                            std::string caption_text = clean_html.substr(tag_close + 1, caption_end - tag_close - 1);
-
-                            // Check if caption is empty or whitespace-only
-                            bool is_empty = true;
-                            for (char c : caption_text)
-                            {
-                                if (!std::isspace(static_cast<unsigned char>(c)))
-                                {
-                                    is_empty = false;
-                                    break;
-                                }
-                            }
-
-                            if (is_empty)
-                            {
-                                // Remove empty caption
-                                clean_html.erase(caption_pos, caption_end + 10 - caption_pos);
-                                std::cerr << "Removed empty caption element" << std::endl;
-                            }
-                            else
-                            {
-                                // Keep caption with content
-                                std::cerr << "Kept caption with text: " << caption_text.substr(0, 30) << "..." << std::endl;
-                                caption_pos = caption_end + 10;
-                            }
-                        }
-                        else
-                        {
-                            caption_pos++;
-                        }
-                    }
-                    else
-                    {
-                        caption_pos++;
-                    }
+                    on_output({output_kind::notice, notice});
                 }
+            }
+            else if (verdict != watchdog_verdict::running)
+            {
+                auto idle_seconds = std::chrono::duration_cast<std::chrono::seconds>(watchdog.idle_for(now)).count();
+                sub.abort_reason = (verdict == watchdog_verdict::hung)
+                    ? "SAS made no progress for " + std::to_string(idle_seconds) + " s; session restarted"
+                    : "Cell exceeded its hard deadline; session restarted";
+                std::cerr << "WARNING: " << sub.abort_reason << std::endl;
+                std::cerr << "  stdout sentinel: " << out.done << std::endl;
+                std::cerr << "  stderr sentinel: " << log.done << std::endl;
+
+                // SAS is still busy with this block; replace it before the
+                // next submission instead of reading its late output
+                m_needs_restart = true;
+                state = read_state::aborted;
+                break;
+            }
 
-                // CRITICAL FIX: Flatten rowspan/colspan attributes for PROC TABULATE
-                // Terminal renderers like euporie cannot handle complex table spans properly
-                // We need to duplicate cells that span multiple rows/columns
-                std::cerr << "Flattening rowspan/colspan attributes..." << std::endl;
+            bool woken = m_poller.wait(events, static_cast<int>(watchdog.next_check(now).count()) + 1);
+            if (woken && m_interrupt_requested)
+            {
+                std::cerr << "Output reader interrupted" << std::endl;
+                state = read_state::aborted;
+                break;
+            }
+            if (woken)
+            {
+                // A worker finished a block (see m_html)
+                deliver_output(sub, out, log, result);
+            }
 
-                // First, parse the table structure to understand row/column layout
-                size_t table_start = clean_html.find("<table");
-                if (table_start != std::string::npos)
+            for (const auto& ev : events)
+            {
+                if (ev.fd == stdin_fd)
                 {
-                    size_t table_end = clean_html.find("</table>", table_start);
-                    if (table_end != std::string::npos)
+                    if (ev.writable || ev.hangup)
                     {
-                        // Extract just the table content for processing
-                        std::string before_table = clean_html.substr(0, table_start);
-                        std::string after_table = clean_html.substr(table_end);
-                        std::string table_html = clean_html.substr(table_start, table_end - table_start);
-
-                        // Build a grid representation of the table
-                        std::vector<std::vector<std::string>> grid;
-                        std::vector<std::vector<bool>> cell_occupied;
-
-                        // Parse rows (both thead and tbody)
-                        size_t row_pos = 0;
-                        int current_row = 0;
-
-                        while ((row_pos = table_html.find("<tr", row_pos)) != std::string::npos)
-                        {
-                            size_t row_end = table_html.find("</tr>", row_pos);
-                            if (row_end == std::string::npos) break;
-
-                            std::string row_content = table_html.substr(row_pos, row_end - row_pos);
-
-                            // Ensure we have enough rows in our grid
-                            if (current_row >= grid.size())
-                            {
-                                grid.resize(current_row + 1);
-                                cell_occupied.resize(current_row + 1);
-                            }
-
-                            // Parse cells in this row
-                            size_t cell_pos = 0;
-                            int current_col = 0;
-
-                            // Find the next available column (skip occupied cells from rowspan)
-                            auto find_next_col = [&]() {
-                                while (current_col < cell_occupied[current_row].size() &&
-                                       cell_occupied[current_row][current_col])
-                                {
-                                    current_col++;
-                                }
-                            };
-
-                            while (true)
-                            {
-                                // Find next cell (th or td)
-                                size_t th_pos = row_content.find("<th", cell_pos);
-                                size_t td_pos = row_content.find("<td", cell_pos);
-                                size_t next_cell = std::min(
-                                    th_pos == std::string::npos ? std::string::npos : th_pos,
-                                    td_pos == std::string::npos ? std::string::npos : td_pos
-                                );
-
-                                if (next_cell == std::string::npos) break;
-
-                                bool is_th = (next_cell == th_pos);
-                                std::string cell_tag = is_th ? "th" : "td";
-                                size_t cell_end = row_content.find("</" + cell_tag + ">", next_cell);
-                                if (cell_end == std::string::npos) break;
-
-                                std::string cell_content = row_content.substr(next_cell, cell_end - next_cell + cell_tag.length() + 3);
-
-                                // Extract rowspan and colspan attributes
-                                int rowspan = 1, colspan = 1;
-                                size_t rowspan_pos = cell_content.find("rowspan=\"");
-                                if (rowspan_pos != std::string::npos)
-                                {
-                                    size_t value_start = rowspan_pos + 9;
-                                    size_t value_end = cell_content.find("\"", value_start);
-                                    if (value_end != std::string::npos)
-                                    {
-                                        rowspan = std::stoi(cell_content.substr(value_start, value_end - value_start));
-                                    }
-                                }
-
-                                size_t colspan_pos = cell_content.find("colspan=\"");
-                                if (colspan_pos != std::string::npos)
-                                {
-                                    size_t value_start = colspan_pos + 9;
-                                    size_t value_end = cell_content.find("\"", value_start);
-                                    if (value_end != std::string::npos)
-                                    {
-                                        colspan = std::stoi(cell_content.substr(value_start, value_end - value_start));
-                                    }
-                                }
-
-                                // Extract cell inner content (between tags)
-                                size_t content_start = cell_content.find(">") + 1;
-                                size_t content_end = cell_content.rfind("</");
-                                std::string inner_content = cell_content.substr(content_start, content_end - content_start);
-
-                                // Remove rowspan/colspan from the cell tag
-                                std::string cleaned_cell = cell_content;
-                                if (rowspan_pos != std::string::npos)
-                                {
-                                    size_t attr_start = rowspan_pos;
-                                    size_t attr_end = cell_content.find("\"", rowspan_pos + 9) + 1;
-                                    cleaned_cell.erase(attr_start, attr_end - attr_start);
-                                    // Remove leading space if present
-                                    if (cleaned_cell[attr_start] == ' ') cleaned_cell.erase(attr_start, 1);
-                                }
-                                if (colspan_pos != std::string::npos)
-                                {
-                                    // Recalculate position after potential rowspan removal
-                                    colspan_pos = cleaned_cell.find("colspan=\"");
-                                    if (colspan_pos != std::string::npos)
-                                    {
-                                        size_t attr_start = colspan_pos;
-                                        size_t attr_end = cleaned_cell.find("\"", colspan_pos + 9) + 1;
-                                        cleaned_cell.erase(attr_start, attr_end - attr_start);
-                                        if (cleaned_cell[attr_start] == ' ') cleaned_cell.erase(attr_start, 1);
-                                    }
-                                }
-
-                                // Find next available column for this cell
-                                find_next_col();
-
-                                // Mark grid positions as occupied for this cell and its span
-                                // For rowspan cells, we'll place the content in the LAST row (bottom-aligned)
-                                // and use empty cells for the earlier rows
-                                for (int r = 0; r < rowspan; r++)
-                                {
-                                    int row_idx = current_row + r;
-                                    if (row_idx >= grid.size())
-                                    {
-                                        grid.resize(row_idx + 1);
-                                        cell_occupied.resize(row_idx + 1);
-                                    }
-
-                                    for (int c = 0; c < colspan; c++)
-                                    {
-                                        int col_idx = current_col + c;
-                                        if (col_idx >= grid[row_idx].size())
-                                        {
-                                            grid[row_idx].resize(col_idx + 1);
-                                            cell_occupied[row_idx].resize(col_idx + 1, false);
-                                        }
-
-                                        // For cells with rowspan, only store content in the last row
-                                        // Use empty cells for earlier rows in the span
-                                        if (rowspan > 1 && r < rowspan - 1)
-                                        {
-                                            // Empty cell for non-last rows in a rowspan
-                                            grid[row_idx][col_idx] = "<td>&#160;</td>";
-                                        }
-                                        else
-                                        {
-                                            // Normal cell or last row of rowspan gets the content
-                                            grid[row_idx][col_idx] = cleaned_cell;
-                                        }
-                                        cell_occupied[row_idx][col_idx] = true;
-                                    }
-                                }
-
-                                current_col += colspan;
-                                cell_pos = cell_end + cell_tag.length() + 3;
-                            }
-
-                            current_row++;
-                            row_pos = row_end + 5;
-                        }
-
-                        // Now reconstruct the table from the grid
-                        std::ostringstream new_table;
-                        new_table << "<table class=\"table\">";
-                        new_table << "<tbody>";
-
-                        for (size_t r = 0; r < grid.size(); r++)
-                        {
-                            new_table << "<tr>";
-                            for (size_t c = 0; c < grid[r].size(); c++)
-                            {
-                                if (!grid[r][c].empty())
-                                {
-                                    new_table << grid[r][c];
-                                }
-                            }
-                            new_table << "</tr>";
-                        }
-
-                        new_table << "</tbody>";
-                        new_table << "</table>";
-
-                        // Reconstruct the full HTML
-                        clean_html = before_table + new_table.str() + after_table;
-                        std::cerr << "Flattened table structure (removed rowspan/colspan)" << std::endl;
+                        write_input(stdin_fd);
                     }
+                    continue;
                 }
-
-                std::cerr << "After simplification, HTML length: " << clean_html.length() << std::endl;
-                std::cerr << "Extracted HTML first 200 chars: " << clean_html.substr(0, std::min<size_t>(200, clean_html.length())) << std::endl;
-                std::cerr << "Extracted HTML last 200 chars: ";
-                if (clean_html.length() > 200)
+                if (ev.fd == exit_fd)
                 {
-                    size_t start = clean_html.length() > 200 ? clean_html.length() - 200 : 0;
-                    std::cerr << clean_html.substr(start) << std::endl;
+                    // Output SAS wrote before dying is still collected from
+                    // the pipes below; the exit is handled after this round
+                    child_exited = true;
+                    continue;
                 }
-                else
+
+                bool is_stdout = (ev.fd == stdout_fd);
+                output_stream& stream = is_stdout ? out : (ev.fd == stderr_fd ? log : listing);
+                if (stream.done || !(ev.readable || ev.hangup))
                 {
-                    std::cerr << "(too short)" << std::endl;
+                    continue;
                 }
-                std::cerr << "Extracted HTML ends with </html>: " << (clean_html.length() >= 7 && clean_html.substr(clean_html.length()-7) == "</html>") << std::endl;
 
-                // Write to debug file
-                std::ofstream debug_file("/tmp/xeus_sas_extracted_html_debug.html");
-                if (debug_file)
+                if (read_stream(ev.fd, stream) == 0)
                 {
-                    debug_file << clean_html;
-                    debug_file.close();
-                    std::cerr << "DEBUG: Wrote extracted HTML to /tmp/xeus_sas_extracted_html_debug.html" << std::endl;
+                    sub.abort_reason = std::string("SAS closed its ")
+                                     + (is_stdout ? "stdout" : (ev.fd == stderr_fd ? "stderr" : "listing"))
+                                     + " stream; session restarted";
+                    std::cerr << sub.abort_reason << std::endl;
+                    state = read_state::aborted;
+
+                    // A process without its output pipes is of no further use
+                    m_needs_restart = true;
                 }
             }
-            else
+
+            // SAS died (OOM kill, abend): fail this block with the exit status
+            // instead of waiting for sentinels that will never come
+            if ((state == read_state::aborted && m_needs_restart) || child_exited)
             {
-                std::cerr << "WARNING: Incomplete HTML detected" << std::endl;
-                std::cerr << "  HTML start position: " << html_start << std::endl;
-                std::cerr << "  HTML end position: " << html_end << std::endl;
-                std::cerr << "  Total output length: " << html_output.length() << std::endl;
-
-                // Log first and last 200 chars for debugging
-                std::cerr << "  First 200 chars: " << html_output.substr(0, 200) << std::endl;
-                if (html_output.length() > 200)
+                // Keep what SAS wrote before it went; EOF can also be seen a
+                // moment before the child can be reaped
+                read_stream(stdout_fd, out);
+                read_stream(stderr_fd, log);
+                read_stream(listing_fd, listing);
+                if (!(out.done && log.done && listing.done) &&
+                    m_process->wait_for_exit(std::chrono::milliseconds(200)))
                 {
-                    size_t start = html_output.length() > 200 ? html_output.length() - 200 : 0;
-                    std::cerr << "  Last 200 chars: " << html_output.substr(start) << std::endl;
+                    sub.abort_reason = "SAS process " + m_process->exit_description() + "; session restarted";
+                    std::cerr << "ERROR: " << sub.abort_reason << std::endl;
+                    m_needs_restart = true;
+                    state = read_state::aborted;
                 }
             }
-            std::cerr << "==========================================\n" << std::endl;
-        }
 
-        // Read listing file if user managed ODS destinations
-        std::string listing_content;
-        if (user_manages_ods)
-        {
-            std::ifstream lst_file(listing_file);
-            if (lst_file)
+            if (state == read_state::aborted)
+            {
+                break;
+            }
+            if (out.done && log.done && listing.done)
+            {
+                if (state == read_state::running)
+                {
+                    first_sentinel_at = clock::now();
+                    end_sample = sample_process(m_process->pid());
+                }
+                state = read_state::complete;
+            }
+            else if ((out.done || log.done) && state == read_state::running)
             {
-                std::stringstream lst_ss;
-                lst_ss << lst_file.rdbuf();
-                listing_content = lst_ss.str();
-                std::cerr << "Read listing file (" << listing_content.length() << " bytes)" << std::endl;
+                first_sentinel_at = clock::now();
+                end_sample = sample_process(m_process->pid());
+                state = read_state::draining;
             }
-            // Clean up temp file
-            std::remove(listing_file.c_str());
         }
 
-        // Create result with both HTML and log
-        execution_result result;
-        result.log = log_output;
-        result.listing = listing_content;
-        result.html_output = clean_html;  // Use extracted clean HTML
-        result.has_html = has_html;
-
-        // Check for errors in log
-        int error_code = 0;
-        result.is_error = contains_error(result.log, error_code);
-        result.error_code = error_code;
-
-        if (result.is_error)
+        // Hand out whatever is left, including a final unterminated log line
+        // and blocks still being cleaned
+        log.flush_lines = true;
+        deliver_output(sub, out, log, result, true);
+
+        m_poller.remove(stdin_fd);
+        m_poller.remove(stdout_fd);
+        m_poller.remove(stderr_fd);
+        m_poller.remove(listing_fd);
+        m_poller.remove(exit_fd);
+        m_stdout_carry = std::move(out.rest);
+        m_stderr_carry = std::move(log.rest);
+        if (sub.user_manages_ods)
         {
-            // Extract error message
-            std::regex error_regex(R"(ERROR:?\s*(.+))");
-            std::smatch match;
-            if (std::regex_search(result.log, match, error_regex))
-            {
-                result.error_message = match[1].str();
-            }
+            m_listing_carry = std::move(listing.rest);
         }
+        fcntl(stdout_fd, F_SETFL, stdout_flags);
+        fcntl(stderr_fd, F_SETFL, stderr_flags);
 
-        // Extract graph files from log
-        result.graph_files = extract_graph_files(result.log);
+        auto finished_at = clock::now();
+        if (state == read_state::complete)
+        {
+            result.sas_time_ms = elapsed_ms(submitted_at, first_sentinel_at);
+            result.drain_time_ms = elapsed_ms(first_sentinel_at, finished_at);
+        }
+        else
+        {
+            result.sas_time_ms = elapsed_ms(submitted_at, finished_at);
+            end_sample = sample_process(m_process->pid());
+        }
+        result.resources = usage_between(start_sample, end_sample, peak_reset);
+        std::cerr << "Execution timing: SAS " << result.sas_time_ms << " ms, drain "
+                  << result.drain_time_ms << " ms; " << format_usage(result.resources, result.sas_time_ms)
+                  << std::endl;
 
-        return result;
-#else
-        // Fallback to batch mode on Windows
-        std::string output = run_sas_batch(code);
-        return parse_execution_output(output);
-#endif
+        return state;
     }
 
     std::string sas_session::impl::run_sas_batch(const std::string& code)
     {
         // Create temporary file for code
-        std::string temp_sas = "/tmp/xeus_sas_temp.sas";
-        std::string temp_log = "/tmp/xeus_sas_temp.log";
-        std::string temp_lst = "/tmp/xeus_sas_temp.lst";
+        std::string temp_sas = m_scratch->file("batch.sas");
+        std::string temp_log = m_scratch->file("batch.log");
+        std::string temp_lst = m_scratch->file("batch.lst");
 
         // Write code to file
         std::ofstream ofs(temp_sas);
@@ -1018,8 +1808,12 @@ namespace xeus_sas
             << " -nodms -noterminal"
             << " -sysin " << temp_sas
             << " -log " << temp_log
-            << " -print " << temp_lst
-            << " 2>&1";
+            << " -print " << temp_lst;
+        for (const auto& option : m_sas_options)
+        {
+            cmd << " " << option;
+        }
+        cmd << " 2>&1";
 
         // Execute SAS
         std::array<char, 128> buffer;
@@ -1078,7 +1872,7 @@ namespace xeus_sas
     {
         // Execute a simple SAS program to get version
         std::string code = "%put &SYSVER;";
-        auto result = execute(code);
+        auto result = execute(code, nullptr);
 
         // Parse version from log
         // This is a placeholder - actual version extraction would be more sophisticated
@@ -1087,66 +1881,73 @@ namespace xeus_sas
 
     bool sas_session::impl::is_ready() const
     {
-        // For batch mode, always ready if SAS path is valid
-        return !m_sas_path.empty();
+        // Ready once a SAS process has finished starting up
+        return m_initialized;
     }
 
     void sas_session::impl::shutdown()
     {
-        if (!m_initialized)
-            return;
+        stop_idle_timer();
 
-        std::cout << "Shutting down SAS session..." << std::endl;
-
-#ifndef _WIN32
-        // Send ENDSAS command to gracefully terminate SAS
-        if (m_sas_stdin)
+        try
         {
-            fprintf(m_sas_stdin, "endsas;\n");
-            fflush(m_sas_stdin);
-            fclose(m_sas_stdin);
-            m_sas_stdin = nullptr;
+            wait_for_startup();
         }
-
-        // Close stdout pipe
-        if (m_sas_stdout)
+        catch (const std::exception& e)
         {
-            fclose(m_sas_stdout);
-            m_sas_stdout = nullptr;
+            std::cerr << "SAS startup failed: " << e.what() << std::endl;
         }
 
-        // Close stderr pipe
-        if (m_sas_stderr)
+        if (!m_initialized)
+            return;
+
+        std::cout << "Shutting down SAS session..." << std::endl;
+
+#ifndef _WIN32
+        // Fail whatever is still in flight, then end SAS
+        m_interrupt_requested = true;
+        stop_reader();
+        discard_input();
+        m_stdout_carry.clear();
+        m_stderr_carry.clear();
+        m_listing_carry.clear();
+        m_process.reset();
+
+        // Let pending refills and reaps finish, then end the standby processes
+        for (auto& task : m_background)
         {
-            fclose(m_sas_stderr);
-            m_sas_stderr = nullptr;
+            task.wait();
         }
+        m_background.clear();
 
-        // Wait for SAS process to terminate
-        if (m_sas_pid > 0)
         {
-            int status;
-            waitpid(m_sas_pid, &status, 0);
-            std::cout << "SAS process terminated (PID: " << m_sas_pid << ")" << std::endl;
-            m_sas_pid = -1;
+            std::lock_guard<std::mutex> lock(m_standby_mutex);
+            m_standby.clear();
         }
 #endif
 
+        // SAS is gone, and with it every user of the scratch directory
+        m_scratch->remove();
         m_initialized = false;
     }
 
     void sas_session::impl::interrupt()
     {
-        if (!m_initialized || m_sas_pid <= 0)
+        if (!m_initialized || !m_process)
             return;
 
         std::cout << "Interrupting SAS session..." << std::endl;
 
 #ifndef _WIN32
-        // Send SIGINT to SAS process
-        if (kill(m_sas_pid, SIGINT) == 0)
+        // Stop the reader from waiting on output; queued blocks are dropped
+        m_interrupt_requested = true;
+        m_poller.wake();
+
+        // Send SIGINT to SAS process (through the broker for a lease)
+        pid_t sas_pid = m_process->pid();
+        if (m_process->interrupt())
         {
-            std::cout << "Interrupt signal sent to SAS (PID: " << m_sas_pid << ")" << std::endl;
+            std::cout << "Interrupt signal sent to SAS (PID: " << sas_pid << ")" << std::endl;
         }
         else
         {
@@ -1158,25 +1959,54 @@ namespace xeus_sas
     void sas_session::impl::restart()
     {
         std::cerr << "=== RESTARTING SAS SESSION ===" << std::endl;
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
 
-        // Shutdown the current session
-        shutdown();
-
-        // Wait a moment for cleanup
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+#ifndef _WIN32
+        try
+        {
+            wait_for_startup();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "SAS startup failed: " << e.what() << std::endl;
+        }
 
-        // Reinitialize the session
+        if (!m_initialized)
+        {
+            initialize_session();
+        }
+        else
+        {
+            // Blocks already written to the old process are lost with it
+            m_interrupt_requested = true;
+            m_poller.wake();
+            wait_until_idle();
+            m_interrupt_requested = false;
+            m_needs_restart = false;
+
+            replace_process();
+        }
+#else
+        shutdown();
         initialize_session();
+#endif
 
         std::cerr << "=== SAS SESSION RESTARTED ===" << std::endl;
-        std::cerr << "WARNING: Session state lost (datasets, macro variables cleared)" << std::endl;
+        if (has_checkpoint())
+        {
+            std::cerr << "Session state will be restored from the last checkpoint" << std::endl;
+        }
+        else
+        {
+            std::cerr << "WARNING: Session state lost (datasets, macro variables cleared)" << std::endl;
+        }
     }
 
     std::string sas_session::impl::get_macro(const std::string& name)
     {
         // Execute %PUT to get macro value
         std::string code = "%put &" + name + ";";
-        auto result = execute(code);
+        auto result = execute(code, nullptr);
 
         // Parse macro value from log
         // This is a placeholder
@@ -1187,7 +2017,282 @@ namespace xeus_sas
     {
         // Execute %LET to set macro
         std::string code = "%let " + name + " = " + value + ";";
-        execute(code);
+        execute(code, nullptr);
+    }
+
+    void sas_session::impl::set_checkpoint_dir(const std::string& directory, bool restore_existing)
+    {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        m_checkpoint_dir = directory;
+        if (!restore_existing)
+        {
+            // A checkpoint left by an earlier kernel must not be replayed
+            // after this kernel's first restart
+            remove_tree(m_checkpoint_dir + "/work");
+            remove_tree(m_checkpoint_dir + "/macros.sas7bdat");
+        }
+        remove_tree(hibernation_dir());
+        m_restore_pending = restore_existing && has_checkpoint();
+    }
+
+    bool sas_session::impl::has_checkpoint() const
+    {
+        return !m_checkpoint_dir.empty() && access((m_checkpoint_dir + "/work").c_str(), F_OK) == 0;
+    }
+
+    bool sas_session::impl::take_due_checkpoint()
+    {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        if (m_checkpoint_dir.empty() || !m_checkpoint_due.exchange(false))
+        {
+            return false;
+        }
+
+#ifndef _WIN32
+        prepare_process();
+        wait_until_idle();
+        return take_checkpoint(m_checkpoint_dir, false);
+#else
+        return false;
+#endif
+    }
+
+    bool sas_session::impl::checkpoint()
+    {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        if (m_checkpoint_dir.empty())
+        {
+            return false;
+        }
+
+#ifndef _WIN32
+        prepare_process();
+        wait_until_idle();
+        m_checkpoint_due = false;
+        return take_checkpoint(m_checkpoint_dir, false);
+#else
+        return false;
+#endif
+    }
+
+#ifndef _WIN32
+    execution_result sas_session::impl::run_internal(const std::string& code)
+    {
+        // Goes through the normal pipeline, so it runs after everything
+        // already submitted; the caller holds m_submit_mutex
+        return enqueue(code, nullptr, execution_limits(), true, false).get();
+    }
+
+    bool sas_session::impl::take_checkpoint(const std::string& directory, bool with_settings)
+    {
+        auto started_at = std::chrono::steady_clock::now();
+        try
+        {
+            make_directories(directory);
+            std::string code = work_path_probe_code() + save_macros_code(directory);
+            if (with_settings)
+            {
+                code += save_settings_code(directory);
+            }
+            auto result = run_internal(code);
+            std::string work_dir = parse_work_path(result.log);
+            if (result.is_error || work_dir.empty())
+            {
+                throw std::runtime_error(result.error_message.empty() ? "WORK path not reported"
+                                                                      : result.error_message);
+            }
+
+            auto stats = sync_work_snapshot(work_dir, directory + "/work");
+            std::cerr << "Checkpoint of WORK, macro variables" << (with_settings ? " and settings" : "")
+                      << " in " << directory << ": "
+                      << stats.cloned << " cloned, " << stats.copied << " copied, "
+                      << stats.unchanged << " unchanged, " << stats.removed << " removed ("
+                      << elapsed_ms(started_at, std::chrono::steady_clock::now()) << " ms)" << std::endl;
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "WARNING: Checkpoint failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool sas_session::impl::restore_checkpoint(const std::string& directory, bool with_settings)
+    {
+        auto started_at = std::chrono::steady_clock::now();
+        try
+        {
+            // Options, librefs and filerefs first, as the user had them
+            // when the state was saved
+            if (with_settings && access((directory + "/settings.sas").c_str(), F_OK) == 0)
+            {
+                auto result = run_internal(restore_settings_code(directory));
+                if (result.is_error)
+                {
+                    std::cerr << "WARNING: Settings not fully restored: " << result.error_message << std::endl;
+                }
+            }
+
+            auto result = run_internal(work_path_probe_code());
+            std::string work_dir = parse_work_path(result.log);
+            if (work_dir.empty())
+            {
+                throw std::runtime_error("WORK path not reported");
+            }
+
+            auto stats = restore_work_snapshot(directory + "/work", work_dir);
+            if (access((directory + "/macros.sas7bdat").c_str(), F_OK) == 0)
+            {
+                result = run_internal(restore_macros_code(directory));
+                if (result.is_error)
+                {
+                    std::cerr << "WARNING: Macro variables not restored: " << result.error_message << std::endl;
+                }
+            }
+
+            std::cerr << "Restored checkpoint from " << directory << ": " << stats.copied
+                      << " WORK members (" << elapsed_ms(started_at, std::chrono::steady_clock::now())
+                      << " ms)" << std::endl;
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "WARNING: Checkpoint restore failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    void sas_session::impl::idle_loop()
+    {
+        std::unique_lock<std::mutex> lock(m_idle_mutex);
+        while (!m_idle_stopping)
+        {
+            auto deadline = m_last_activity + m_idle_timeout;
+            if (std::chrono::steady_clock::now() < deadline)
+            {
+                m_idle_changed.wait_until(lock, deadline);
+                continue;
+            }
+
+            lock.unlock();
+            hibernate();
+            lock.lock();
+
+            // Busy or already hibernated: look again after another period
+            m_last_activity = std::chrono::steady_clock::now();
+        }
+    }
+
+    void sas_session::impl::hibernate()
+    {
+        // A submit in progress means the session is not idle after all
+        std::unique_lock<std::mutex> lock(m_submit_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || m_hibernated || !m_process || m_needs_restart)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> queue_lock(m_queue_mutex);
+            if (!m_in_flight.empty())
+            {
+                return;
+            }
+        }
+        if (m_checkpoint_dir.empty())
+        {
+            std::cerr << "Idle hibernation needs a checkpoint directory; keeping SAS running" << std::endl;
+            return;
+        }
+
+        // With a checkpoint still to be replayed the process holds nothing
+        // of its own; resume() leaves that replay to prepare_process()
+        remove_tree(hibernation_dir());
+        if (!m_restore_pending && !take_checkpoint(hibernation_dir(), true))
+        {
+            std::cerr << "WARNING: Session state could not be saved; not hibernating" << std::endl;
+            return;
+        }
+
+        // End the standby processes as well; their memory is what
+        // hibernation is meant to give back. Pending refills finish first.
+        for (auto& task : m_background)
+        {
+            task.wait();
+        }
+        m_background.clear();
+
+        std::deque<std::unique_ptr<sas_process>> standby;
+        {
+            std::lock_guard<std::mutex> standby_lock(m_standby_mutex);
+            standby.swap(m_standby);
+        }
+        for (auto& process : standby)
+        {
+            reap_in_background(std::move(process));
+        }
+
+        m_stdout_carry.clear();
+        m_stderr_carry.clear();
+        m_listing_carry.clear();
+        reap_in_background(std::move(m_process));
+        m_hibernated = true;
+        std::cerr << "SAS session idle for " << m_idle_timeout.count() / 1000
+                  << " s; hibernated with its state in " << hibernation_dir() << std::endl;
+    }
+
+    void sas_session::impl::resume()
+    {
+        auto started_at = std::chrono::steady_clock::now();
+        std::cerr << "Resuming SAS session from hibernation" << std::endl;
+
+        m_process = take_standby();
+        if (!m_process)
+        {
+            m_process = start_process();
+        }
+        m_hibernated = false;
+
+        bool restored = m_restore_pending || restore_checkpoint(hibernation_dir(), true);
+        remove_tree(hibernation_dir());
+
+        std::ostringstream notice;
+        notice << std::fixed << std::setprecision(1)
+               << "SAS session resumed after idle hibernation in "
+               << elapsed_ms(started_at, std::chrono::steady_clock::now()) / 1000.0 << " s";
+        if (!restored)
+        {
+            notice << "; WARNING: its state could not be restored";
+        }
+        notice << "\n";
+        m_resume_notice = notice.str();
+
+        refill_standby();
+    }
+#endif
+
+    std::string sas_session::impl::hibernation_dir() const
+    {
+        return m_checkpoint_dir + "/hibernate";
+    }
+
+    void sas_session::impl::note_activity()
+    {
+        std::lock_guard<std::mutex> lock(m_idle_mutex);
+        m_last_activity = std::chrono::steady_clock::now();
+    }
+
+    void sas_session::impl::stop_idle_timer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_idle_mutex);
+            m_idle_stopping = true;
+        }
+        m_idle_changed.notify_all();
+
+        if (m_idle_timer.joinable())
+        {
+            m_idle_timer.join();
+        }
     }
 
     // Public API implementation
@@ -1202,9 +2307,32 @@ namespace xeus_sas
         // Cleanup handled by unique_ptr
     }
 
+    void sas_session::start()
+    {
+        m_impl->start();
+    }
+
     execution_result sas_session::execute(const std::string& code)
     {
-        return m_impl->execute(code);
+        return m_impl->execute(code, nullptr);
+    }
+
+    execution_result sas_session::execute(const std::string& code, const output_callback& on_output)
+    {
+        return m_impl->execute(code, on_output);
+    }
+
+    std::future<execution_result> sas_session::submit(const std::string& code,
+                                                      const output_callback& on_output,
+                                                      const execution_limits& limits,
+                                                      bool checkpoint_after)
+    {
+        return m_impl->submit(code, on_output, limits, checkpoint_after);
+    }
+
+    void sas_session::set_limits(const execution_limits& limits)
+    {
+        m_impl->set_limits(limits);
     }
 
     std::string sas_session::get_version()
@@ -1242,4 +2370,24 @@ namespace xeus_sas
         m_impl->set_macro(name, value);
     }
 
+    void sas_session::set_checkpoint_dir(const std::string& directory, bool restore_existing)
+    {
+        m_impl->set_checkpoint_dir(directory, restore_existing);
+    }
+
+    bool sas_session::checkpoint()
+    {
+        return m_impl->checkpoint();
+    }
+
+    bool sas_session::take_due_checkpoint()
+    {
+        return m_impl->take_due_checkpoint();
+    }
+
+    bool sas_session::has_checkpoint() const
+    {
+        return m_impl->has_checkpoint();
+    }
+
 } // namespace xeus_sas
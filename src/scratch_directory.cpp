@@ -0,0 +1,225 @@
+#include "xeus-sas/scratch_directory.hpp"
+#include "xeus-sas/work_checkpoint.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+
+namespace xeus_sas
+{
+    namespace
+    {
+        // statfs f_type of tmpfs (linux/magic.h)
+        const long tmpfs_magic = 0x01021994;
+
+        // The lock file of @p directory, opened close-on-exec so SAS and
+        // its children do not keep the lock alive; -1 if missing
+        int open_lock_file(const std::string& directory, bool create)
+        {
+            std::string path = directory + "/" + directory_lock::file_name;
+            return open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0600);
+        }
+    }
+
+    // directory_lock
+
+    directory_lock::~directory_lock()
+    {
+        release();
+    }
+
+    void directory_lock::acquire(const std::string& directory)
+    {
+        release();
+        int fd = open_lock_file(directory, true);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot create lock file in " + directory + ": " + std::strerror(errno));
+        }
+        int rc;
+        do
+        {
+            rc = flock(fd, LOCK_EX | LOCK_NB);
+        } while (rc != 0 && errno == EINTR);
+        if (rc != 0)
+        {
+            std::string error = std::strerror(errno);
+            close(fd);
+            throw std::runtime_error("Cannot lock " + directory + ": " + error);
+        }
+        m_fd = fd;
+    }
+
+    void directory_lock::release()
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool directory_lock::held() const
+    {
+        return m_fd >= 0;
+    }
+
+    // scratch_directory
+
+    std::string scratch_directory::default_base()
+    {
+        const char* scratch_env = std::getenv("XEUS_SAS_SCRATCH_DIR");
+        if (scratch_env && *scratch_env)
+        {
+            return std::string(scratch_env) == "tmpfs" ? "/dev/shm" : scratch_env;
+        }
+        const char* tmpdir_env = std::getenv("TMPDIR");
+        if (tmpdir_env && *tmpdir_env)
+        {
+            return tmpdir_env;
+        }
+        return "/tmp";
+    }
+
+    scratch_directory::scratch_directory(const std::string& base)
+    {
+        std::string pattern = base + "/" + name_prefix + std::to_string(getpid()) + "-XXXXXX";
+        std::vector<char> buffer(pattern.begin(), pattern.end());
+        buffer.push_back('\0');
+        if (!mkdtemp(buffer.data()))
+        {
+            throw std::runtime_error("Cannot create scratch directory in " + base + ": " + std::strerror(errno));
+        }
+        m_path = buffer.data();
+        ensure();
+    }
+
+    scratch_directory::~scratch_directory()
+    {
+        remove();
+    }
+
+    const std::string& scratch_directory::path() const
+    {
+        return m_path;
+    }
+
+    std::string scratch_directory::work_dir() const
+    {
+        return m_path + "/work";
+    }
+
+    std::string scratch_directory::file(const std::string& name) const
+    {
+        return m_path + "/" + name;
+    }
+
+    bool scratch_directory::on_tmpfs() const
+    {
+#ifdef __linux__
+        struct statfs info;
+        return statfs(m_path.c_str(), &info) == 0 && static_cast<long>(info.f_type) == tmpfs_magic;
+#else
+        return false;
+#endif
+    }
+
+    void scratch_directory::ensure()
+    {
+        for (const std::string& directory : {m_path, work_dir()})
+        {
+            if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST)
+            {
+                throw std::runtime_error("Cannot create scratch directory " + directory + ": " +
+                                         std::strerror(errno));
+            }
+        }
+        if (!m_lock.held())
+        {
+            m_lock.acquire(m_path);
+        }
+    }
+
+    void scratch_directory::remove()
+    {
+        remove_tree(m_path);
+        m_lock.release();
+    }
+
+    size_t sweep_orphaned_directories(const std::string& base, const std::string& prefix)
+    {
+        DIR* handle = opendir(base.c_str());
+        if (!handle)
+        {
+            return 0;
+        }
+
+        // Locked by us until removed, so an owner cannot start using them
+        std::vector<std::pair<std::string, int>> orphans;
+        while (struct dirent* entry = readdir(handle))
+        {
+            std::string name = entry->d_name;
+            if (name.compare(0, prefix.size(), prefix) != 0)
+            {
+                continue;
+            }
+
+            // <prefix><pid>[-...]
+            size_t end = prefix.size();
+            while (end < name.size() && name[end] >= '0' && name[end] <= '9')
+            {
+                ++end;
+            }
+            if (end == prefix.size() || (end < name.size() && name[end] != '-'))
+            {
+                continue;
+            }
+
+            // Only our own directories, and only once nobody holds their
+            // lock. The PID in the name says nothing about kernels in other
+            // PID namespaces or on other hosts sharing the file system.
+            struct stat info;
+            std::string path = base + "/" + name;
+            if (lstat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != getuid())
+            {
+                continue;
+            }
+            int fd = open_lock_file(path, false);
+            if (fd < 0)
+            {
+                continue;
+            }
+            if (flock(fd, LOCK_EX | LOCK_NB) == 0)
+            {
+                orphans.emplace_back(path, fd);
+            }
+            else
+            {
+                close(fd);
+            }
+        }
+        closedir(handle);
+
+        for (const auto& orphan : orphans)
+        {
+            std::cerr << "Removing directory of a kernel that is gone: " << orphan.first << std::endl;
+            remove_tree(orphan.first);
+            close(orphan.second);
+        }
+        return orphans.size();
+    }
+
+} // namespace xeus_sas
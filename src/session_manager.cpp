@@ -0,0 +1,344 @@
+#include "xeus-sas/session_manager.hpp"
+#include "xeus-sas/sas_session.hpp"
+#include "xeus-sas/work_checkpoint.hpp"
+#include "xeus-sas/scratch_directory.hpp"
+
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+namespace xeus_sas
+{
+    const char* const default_session_name = "default";
+
+    namespace
+    {
+        // Default checkpoint roots: <scratch base>/<prefix><kernel pid>
+        const char* const checkpoint_prefix = "xeus_sas_checkpoint_";
+
+        bool is_blank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        std::vector<std::string> split_words(const std::string& text)
+        {
+            std::vector<std::string> words;
+            size_t pos = 0;
+            while (pos < text.size())
+            {
+                while (pos < text.size() && is_blank(text[pos]))
+                    ++pos;
+                size_t start = pos;
+                while (pos < text.size() && !is_blank(text[pos]))
+                    ++pos;
+                if (pos > start)
+                    words.push_back(text.substr(start, pos - start));
+            }
+            return words;
+        }
+
+        void apply_session(const std::vector<std::string>& args, cell_target& target)
+        {
+            if (args.size() != 1)
+            {
+                throw std::invalid_argument(args.empty() ? "%%session requires a session name"
+                                                         : "Invalid session name: " + args[1]);
+            }
+            for (char c : args[0])
+            {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-')
+                {
+                    throw std::invalid_argument("Invalid session name: " + args[0]);
+                }
+            }
+            target.session = args[0];
+        }
+
+        void apply_checkpoint(const std::vector<std::string>& args, cell_target& target)
+        {
+            if (!args.empty())
+            {
+                throw std::invalid_argument("%%checkpoint takes no arguments");
+            }
+            target.checkpoint = true;
+        }
+
+        void apply_limits(const std::vector<std::string>& args, cell_target& target)
+        {
+            if (args.empty())
+            {
+                throw std::invalid_argument("%%limits requires soft=, hard= or hang=");
+            }
+            for (const auto& arg : args)
+            {
+                size_t eq = arg.find('=');
+                std::string key = arg.substr(0, eq);
+                std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+                if (key == "soft")
+                    target.limits.soft_deadline = parse_duration(value);
+                else if (key == "hard")
+                    target.limits.hard_deadline = parse_duration(value);
+                else if (key == "hang")
+                    target.limits.hang_timeout = parse_duration(value);
+                else
+                    throw std::invalid_argument("Unknown %%limits option: " + arg);
+            }
+        }
+    }
+
+    cell_target parse_cell_magics(const std::string& code)
+    {
+        cell_target target;
+        target.session = default_session_name;
+
+        // Magics are the leading lines that start with one of ours; anything
+        // else (including unknown %% lines) is left for SAS
+        size_t body_start = 0;
+        size_t pos = code.find_first_not_of(" \t\r\n");
+        while (pos != std::string::npos && code.compare(pos, 2, "%%") == 0)
+        {
+            size_t line_end = code.find('\n', pos);
+            auto words = split_words(code.substr(pos + 2, line_end == std::string::npos
+                                                              ? std::string::npos
+                                                              : line_end - pos - 2));
+            std::string magic = words.empty() ? "" : words[0];
+            std::vector<std::string> args;
+            if (!words.empty())
+            {
+                args.assign(words.begin() + 1, words.end());
+            }
+
+            if (magic == "session")
+                apply_session(args, target);
+            else if (magic == "limits")
+                apply_limits(args, target);
+            else if (magic == "checkpoint")
+                apply_checkpoint(args, target);
+            else
+                break;
+
+            body_start = (line_end == std::string::npos) ? code.size() : line_end + 1;
+            pos = code.find_first_not_of(" \t\r\n", body_start);
+        }
+
+        target.code = code.substr(body_start);
+        return target;
+    }
+
+    struct session_manager::worker
+    {
+        struct queued_job
+        {
+            job work;
+            drop_handler on_drop;
+        };
+
+        std::unique_ptr<sas_session> session;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::deque<queued_job> queue;
+        bool running = false;                 // A job is executing
+        bool stopping = false;
+
+        void run()
+        {
+            while (true)
+            {
+                job next;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wakeup.wait(lock, [this]() { return stopping || !queue.empty(); });
+                    if (stopping)
+                    {
+                        return;
+                    }
+                    next = std::move(queue.front().work);
+                    queue.pop_front();
+                    running = true;
+                }
+
+                try
+                {
+                    next(*session);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Session job failed: " << e.what() << std::endl;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                running = false;
+            }
+        }
+    };
+
+    session_manager::session_manager(const std::string& sas_path)
+        : m_sas_path(sas_path)
+        , m_owns_checkpoint_root(false)
+        , m_restore_checkpoints(false)
+    {
+        const char* checkpoint_root = std::getenv("XEUS_SAS_CHECKPOINT_DIR");
+        if (checkpoint_root && *checkpoint_root)
+        {
+            m_checkpoint_root = checkpoint_root;
+            const char* restore = std::getenv("XEUS_SAS_CHECKPOINT_RESTORE");
+            m_restore_checkpoints = restore && std::string(restore) == "1";
+        }
+        else
+        {
+            m_checkpoint_root = scratch_directory::default_base() + "/" + checkpoint_prefix +
+                                std::to_string(getpid());
+            m_owns_checkpoint_root = true;
+
+            // Locked so that other kernels' sweeps leave it alone
+            try
+            {
+                make_directories(m_checkpoint_root);
+                m_checkpoint_lock.acquire(m_checkpoint_root);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "WARNING: " << e.what() << std::endl;
+            }
+        }
+
+        // Scratch and checkpoint directories of kernels that were killed
+        // before they could remove them
+        sweep_orphaned_directories(scratch_directory::default_base(), scratch_directory::name_prefix);
+        sweep_orphaned_directories(scratch_directory::default_base(), checkpoint_prefix);
+    }
+
+    session_manager::~session_manager()
+    {
+        shutdown();
+    }
+
+    session_manager::worker& session_manager::get_worker(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_workers.find(name);
+        if (it != m_workers.end())
+        {
+            return *it->second;
+        }
+
+        std::cerr << "Creating SAS session '" << name << "'" << std::endl;
+
+        auto w = std::make_unique<worker>();
+        w->session = std::make_unique<sas_session>(m_sas_path);
+        w->session->set_checkpoint_dir(m_checkpoint_root + "/" + name, m_restore_checkpoints);
+        w->session->start();
+        w->thread = std::thread(&worker::run, w.get());
+
+        worker& result = *w;
+        m_workers.emplace(name, std::move(w));
+        return result;
+    }
+
+    sas_session& session_manager::get(const std::string& name)
+    {
+        return *get_worker(name).session;
+    }
+
+    void session_manager::submit(const std::string& name, job work, drop_handler on_drop)
+    {
+        worker& w = get_worker(name);
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.queue.push_back({std::move(work), std::move(on_drop)});
+        }
+        w.wakeup.notify_one();
+    }
+
+    bool session_manager::busy(const std::string& name) const
+    {
+        worker* w = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_workers.find(name);
+            if (it == m_workers.end())
+            {
+                return false;
+            }
+            w = it->second.get();
+        }
+
+        std::lock_guard<std::mutex> lock(w->mutex);
+        return w->running || !w->queue.empty();
+    }
+
+    std::vector<std::string> session_manager::names() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<std::string> result;
+        for (const auto& entry : m_workers)
+        {
+            result.push_back(entry.first);
+        }
+        return result;
+    }
+
+    void session_manager::shutdown()
+    {
+        std::map<std::string, std::unique_ptr<worker>> workers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            workers.swap(m_workers);
+        }
+
+        for (auto& entry : workers)
+        {
+            worker& w = *entry.second;
+            std::deque<worker::queued_job> dropped;
+            {
+                std::lock_guard<std::mutex> lock(w.mutex);
+                w.stopping = true;
+                dropped.swap(w.queue);
+            }
+            w.wakeup.notify_one();
+
+            // Whoever queued a job may still be waiting for it (an execute
+            // request waits for its reply)
+            for (auto& queued : dropped)
+            {
+                if (!queued.on_drop)
+                {
+                    continue;
+                }
+                try
+                {
+                    queued.on_drop();
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Dropping session job failed: " << e.what() << std::endl;
+                }
+            }
+
+            // Abort a running cell so the worker can be joined
+            w.session->interrupt();
+            if (w.thread.joinable())
+            {
+                w.thread.join();
+            }
+            w.session->shutdown();
+        }
+
+        if (m_owns_checkpoint_root)
+        {
+            remove_tree(m_checkpoint_root);
+            m_checkpoint_lock.release();
+        }
+    }
+
+} // namespace xeus_sas
@@ -0,0 +1,120 @@
+#include "xeus-sas/stream_scanner.hpp"
+
+#include <queue>
+#include <stdexcept>
+
+namespace xeus_sas
+{
+    stream_scanner::stream_scanner(const std::vector<std::string>& patterns)
+        : m_patterns(patterns)
+        , m_state(0)
+        , m_offset(0)
+    {
+        // Build the trie; -1 marks a missing edge until failure links fill it
+        m_transitions.assign(256, -1);
+        m_output.emplace_back();
+
+        for (size_t p = 0; p < m_patterns.size(); ++p)
+        {
+            if (m_patterns[p].empty())
+            {
+                throw std::invalid_argument("stream_scanner patterns must not be empty");
+            }
+
+            int32_t state = 0;
+            for (unsigned char c : m_patterns[p])
+            {
+                int32_t& next = m_transitions[state * 256 + c];
+                if (next < 0)
+                {
+                    next = static_cast<int32_t>(m_output.size());
+                    m_output.emplace_back();
+                    m_transitions.resize(m_transitions.size() + 256, -1);
+                }
+                state = m_transitions[state * 256 + c];
+            }
+            m_output[state].push_back(p);
+        }
+
+        // Breadth-first pass turns the trie into a complete DFA: missing edges
+        // follow the failure link, and outputs inherit the failure state's
+        std::vector<int32_t> failure(m_output.size(), 0);
+        std::queue<int32_t> pending;
+
+        for (int c = 0; c < 256; ++c)
+        {
+            int32_t& next = m_transitions[c];
+            if (next < 0)
+            {
+                next = 0;
+            }
+            else
+            {
+                pending.push(next);
+            }
+        }
+
+        while (!pending.empty())
+        {
+            int32_t state = pending.front();
+            pending.pop();
+
+            const auto& inherited = m_output[failure[state]];
+            m_output[state].insert(m_output[state].end(), inherited.begin(), inherited.end());
+
+            for (int c = 0; c < 256; ++c)
+            {
+                int32_t& next = m_transitions[state * 256 + c];
+                int32_t fallback = m_transitions[failure[state] * 256 + c];
+                if (next < 0)
+                {
+                    next = fallback;
+                }
+                else
+                {
+                    failure[next] = fallback;
+                    pending.push(next);
+                }
+            }
+        }
+    }
+
+    void stream_scanner::feed(const char* data, size_t length, std::vector<scan_match>& matches)
+    {
+        const int32_t* transitions = m_transitions.data();
+        int32_t state = m_state;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            state = transitions[state * 256 + static_cast<unsigned char>(data[i])];
+            if (!m_output[state].empty())
+            {
+                size_t end = m_offset + i + 1;
+                for (size_t p : m_output[state])
+                {
+                    matches.push_back({p, end - m_patterns[p].size()});
+                }
+            }
+        }
+
+        m_state = state;
+        m_offset += length;
+    }
+
+    void stream_scanner::reset()
+    {
+        m_state = 0;
+        m_offset = 0;
+    }
+
+    size_t stream_scanner::bytes_scanned() const
+    {
+        return m_offset;
+    }
+
+    size_t stream_scanner::pattern_length(size_t index) const
+    {
+        return m_patterns.at(index).size();
+    }
+
+} // namespace xeus_sas
@@ -0,0 +1,370 @@
+#include "xeus-sas/work_checkpoint.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace xeus_sas
+{
+    namespace
+    {
+        const char* const work_marker = "XEUS_SAS_WORK=";
+
+        std::vector<std::string> list_members(const std::string& dir)
+        {
+            DIR* handle = opendir(dir.c_str());
+            if (!handle)
+            {
+                throw std::runtime_error("Cannot read directory " + dir + ": " + std::strerror(errno));
+            }
+
+            std::vector<std::string> members;
+            while (struct dirent* entry = readdir(handle))
+            {
+                std::string name = entry->d_name;
+                struct stat info;
+                if (is_library_member(name) && stat((dir + "/" + name).c_str(), &info) == 0 &&
+                    S_ISREG(info.st_mode))
+                {
+                    members.push_back(name);
+                }
+            }
+            closedir(handle);
+            return members;
+        }
+
+        const struct timespec& modified(const struct stat& info)
+        {
+#ifdef __APPLE__
+            return info.st_mtimespec;
+#else
+            return info.st_mtim;
+#endif
+        }
+
+        // Same contents as far as a quick check can tell: same size and
+        // modification time, but not the same file
+        bool same_version(const struct stat& a, const struct stat& b)
+        {
+            return !(a.st_dev == b.st_dev && a.st_ino == b.st_ino) && a.st_size == b.st_size &&
+                   modified(a).tv_sec == modified(b).tv_sec && modified(a).tv_nsec == modified(b).tv_nsec;
+        }
+
+        // Copy through a temporary name, so a reader never sees half a
+        // member. The copy gets the source's modification time, so that
+        // same_version() recognizes it later.
+        bool copy_file(const std::string& from, const std::string& to, bool& cloned)
+        {
+            int in = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in < 0)
+            {
+                return false;
+            }
+            struct stat info;
+            if (fstat(in, &info) != 0)
+            {
+                close(in);
+                return false;
+            }
+            std::string partial = to + ".partial";
+            int out = open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (out < 0)
+            {
+                close(in);
+                return false;
+            }
+
+            bool ok = true;
+            ssize_t bytes_read = 0;
+#ifdef FICLONE
+            cloned = ioctl(out, FICLONE, in) == 0;
+#else
+            cloned = false;
+#endif
+            if (!cloned)
+            {
+                std::vector<char> buffer(1 << 20);
+                while (ok && (bytes_read = read(in, buffer.data(), buffer.size())) > 0)
+                {
+                    for (ssize_t written = 0; ok && written < bytes_read;)
+                    {
+                        ssize_t n = write(out, buffer.data() + written, static_cast<size_t>(bytes_read - written));
+                        ok = (n > 0);
+                        written += ok ? n : 0;
+                    }
+                }
+                ok = ok && bytes_read == 0;
+            }
+            struct timespec times[2] = {{0, UTIME_OMIT}, modified(info)};
+            ok = ok && futimens(out, times) == 0;
+            close(in);
+            ok = (close(out) == 0) && ok;
+
+            if (!ok || rename(partial.c_str(), to.c_str()) != 0)
+            {
+                unlink(partial.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        // Quote a path for a SAS string literal; single quotes keep '&' and
+        // '%' in the path away from the macro processor
+        std::string sas_quote(const std::string& text)
+        {
+            std::string quoted = "'";
+            for (char c : text)
+            {
+                quoted += c;
+                if (c == '\'')
+                {
+                    quoted += c;
+                }
+            }
+            return quoted + "'";
+        }
+
+        bool ends_with(const std::string& text, const char* suffix)
+        {
+            size_t length = std::strlen(suffix);
+            return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+        }
+    }
+
+    bool is_library_member(const std::string& file_name)
+    {
+        for (const char* extension : {".sas7bdat", ".sas7bvew", ".sas7bcat", ".sas7bndx"})
+        {
+            if (ends_with(file_name, extension))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    checkpoint_stats sync_work_snapshot(const std::string& work_dir, const std::string& snapshot_dir)
+    {
+        make_directories(snapshot_dir);
+
+        checkpoint_stats stats;
+        std::set<std::string> current;
+        for (const auto& name : list_members(work_dir))
+        {
+            current.insert(name);
+            std::string source = work_dir + "/" + name;
+            std::string target = snapshot_dir + "/" + name;
+
+            struct stat source_info;
+            struct stat target_info;
+            if (stat(source.c_str(), &source_info) != 0)
+            {
+                continue;   // Deleted meanwhile
+            }
+            if (stat(target.c_str(), &target_info) == 0 && same_version(source_info, target_info))
+            {
+                ++stats.unchanged;
+                continue;
+            }
+
+            // A hard link left by an older snapshot is replaced as well
+            bool cloned = false;
+            if (!copy_file(source, target, cloned))
+            {
+                throw std::runtime_error("Cannot checkpoint " + source + ": " + std::strerror(errno));
+            }
+            ++(cloned ? stats.cloned : stats.copied);
+        }
+
+        for (const auto& name : list_members(snapshot_dir))
+        {
+            if (current.count(name) == 0 && unlink((snapshot_dir + "/" + name).c_str()) == 0)
+            {
+                ++stats.removed;
+            }
+        }
+        return stats;
+    }
+
+    checkpoint_stats restore_work_snapshot(const std::string& snapshot_dir, const std::string& work_dir)
+    {
+        checkpoint_stats stats;
+        for (const auto& name : list_members(snapshot_dir))
+        {
+            std::string target = work_dir + "/" + name;
+            bool cloned = false;
+            if (access(target.c_str(), F_OK) == 0)
+            {
+                ++stats.unchanged;
+            }
+            else if (copy_file(snapshot_dir + "/" + name, target, cloned))
+            {
+                ++(cloned ? stats.cloned : stats.copied);
+            }
+            else
+            {
+                throw std::runtime_error("Cannot restore " + name + " into " + work_dir + ": " +
+                                         std::strerror(errno));
+            }
+        }
+        return stats;
+    }
+
+    void make_directories(const std::string& path)
+    {
+        for (size_t pos = 0; pos != std::string::npos;)
+        {
+            pos = path.find('/', pos + 1);
+            std::string prefix = path.substr(0, pos);
+            if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST)
+            {
+                throw std::runtime_error("Cannot create directory " + prefix + ": " + std::strerror(errno));
+            }
+        }
+    }
+
+    void remove_tree(const std::string& path)
+    {
+        struct stat info;
+        if (lstat(path.c_str(), &info) != 0)
+        {
+            return;
+        }
+        if (S_ISDIR(info.st_mode))
+        {
+            if (DIR* handle = opendir(path.c_str()))
+            {
+                while (struct dirent* entry = readdir(handle))
+                {
+                    std::string name = entry->d_name;
+                    if (name != "." && name != "..")
+                    {
+                        remove_tree(path + "/" + name);
+                    }
+                }
+                closedir(handle);
+            }
+            rmdir(path.c_str());
+        }
+        else
+        {
+            unlink(path.c_str());
+        }
+    }
+
+    std::string work_path_probe_code()
+    {
+        // %str() keeps the echoed source line from matching
+        return "%put XEUS_SAS_%str()WORK=%sysfunc(pathname(work));\n";
+    }
+
+    std::string parse_work_path(const std::string& log)
+    {
+        size_t pos = 0;
+        while ((pos = log.find(work_marker, pos)) != std::string::npos)
+        {
+            if (pos == 0 || log[pos - 1] == '\n')
+            {
+                size_t start = pos + std::strlen(work_marker);
+                size_t end = log.find_first_of("\r\n", start);
+                return log.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            }
+            ++pos;
+        }
+        return std::string();
+    }
+
+    std::string save_macros_code(const std::string& checkpoint_dir)
+    {
+        return "libname _xsckpt " + sas_quote(checkpoint_dir) + ";\n"
+               "data _xsckpt.macros;\n"
+               "    set sashelp.vmacro(where=(scope = 'GLOBAL' and name not like 'SYS%'));\n"
+               "run;\n"
+               "libname _xsckpt clear;\n";
+    }
+
+    std::string restore_macros_code(const std::string& checkpoint_dir)
+    {
+        // Long values are stored in 200-character pieces at increasing offsets
+        return "libname _xsckpt " + sas_quote(checkpoint_dir) + " access=readonly;\n"
+               "data _null_;\n"
+               "    set _xsckpt.macros;\n"
+               "    by name notsorted;\n"
+               "    length _xs_value $32767;\n"
+               "    retain _xs_value;\n"
+               "    if first.name then _xs_value = '';\n"
+               "    if offset + 200 <= 32767 then substr(_xs_value, offset + 1, 200) = value;\n"
+               "    if last.name then call symputx(name, _xs_value, 'G');\n"
+               "run;\n"
+               "libname _xsckpt clear;\n";
+    }
+
+    std::string save_settings_code(const std::string& checkpoint_dir)
+    {
+        // On Unix, SASHELP.VLIBNAM has several rows per library level, one
+        // per SYSNAME (Filename, Inode Number, Owner Name, ...), so only the
+        // first row of each level counts. Concatenated librefs and filerefs
+        // have one level per member; their paths are collected and written
+        // as one statement. QUOTE with a single quote keeps '&' and '%' in
+        // paths literal on %INCLUDE.
+        std::string statements = sas_quote(checkpoint_dir + "/settings.sas");
+        return "libname _xsckpt " + sas_quote(checkpoint_dir) + ";\n"
+               "proc optsave out=_xsckpt.options;\n"
+               "run;\n"
+               "data _null_;\n"
+               "    file " + statements + ";\n"
+               "    set sashelp.vlibnam(where=(libname not in "
+               "('WORK' 'SASHELP' 'SASUSER' 'MAPS' 'MAPSSAS' 'MAPSGFK' '_XSCKPT')));\n"
+               "    by libname level notsorted;\n"
+               "    length _xs_paths $32767;\n"
+               "    retain _xs_paths;\n"
+               "    if first.libname then do;\n"
+               "        _xs_paths = '';\n"
+               "        _xs_levels = 0;\n"
+               "    end;\n"
+               "    if first.level then do;\n"
+               "        _xs_paths = catx(' ', _xs_paths, quote(trim(path), \"'\"));\n"
+               "        _xs_levels + 1;\n"
+               "    end;\n"
+               "    if last.libname then do;\n"
+               "        if _xs_levels = 1 then put 'libname ' libname engine _xs_paths ';';\n"
+               "        else put 'libname ' libname '(' _xs_paths ');';\n"
+               "    end;\n"
+               "run;\n"
+               "data _null_;\n"
+               "    file " + statements + " mod;\n"
+               "    set sashelp.vextfl(where=(temporary = 'no' and fileref not like '#%'));\n"
+               "    by fileref notsorted;\n"
+               "    length _xs_paths $32767;\n"
+               "    retain _xs_paths;\n"
+               "    if first.fileref then _xs_paths = '';\n"
+               "    _xs_paths = catx(' ', _xs_paths, quote(trim(xpath), \"'\"));\n"
+               "    if last.fileref then do;\n"
+               "        if first.fileref then put 'filename ' fileref _xs_paths ';';\n"
+               "        else put 'filename ' fileref '(' _xs_paths ');';\n"
+               "    end;\n"
+               "run;\n"
+               "libname _xsckpt clear;\n";
+    }
+
+    std::string restore_settings_code(const std::string& checkpoint_dir)
+    {
+        return "libname _xsckpt " + sas_quote(checkpoint_dir) + " access=readonly;\n"
+               "proc optload data=_xsckpt.options;\n"
+               "run;\n"
+               "libname _xsckpt clear;\n"
+               "%include " + sas_quote(checkpoint_dir + "/settings.sas") + ";\n";
+    }
+
+} // namespace xeus_sas
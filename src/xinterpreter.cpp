@@ -1,57 +1,157 @@
 #include "xeus-sas/xinterpreter.hpp"
+#include "xeus-sas/iopub_server.hpp"
 #include "xeus-sas/sas_session.hpp"
+#include "xeus-sas/session_manager.hpp"
+#include "xeus-sas/event_poller.hpp"
 #include "xeus-sas/sas_parser.hpp"
 #include "xeus-sas/completion.hpp"
 #include "xeus-sas/inspection.hpp"
+#include "xeus-sas/resource_usage.hpp"
 #include "xeus-sas/xeus_sas_config.hpp"
 
 #include "xeus/xinterpreter.hpp"
 
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <regex>
 #include <sstream>
 #include <atomic>
 
+#include <unistd.h>
+
 namespace xeus_sas
 {
+    namespace
+    {
+        // Booktabs-style CSS injected with every HTML output
+        const char* const table_style = "<style>\n"
+            ".sas-table, .sas-table table, table.table {\n"
+            "  border-collapse: collapse;\n"
+            "  border: none;\n"
+            "}\n"
+            ".sas-table td, .sas-table th,\n"
+            "table.table td, table.table th {\n"
+            "  border: none;\n"
+            "  padding: 4px 8px;\n"
+            "}\n"
+            "/* Toprule: first row with headers */\n"
+            ".sas-table tbody tr:first-child th,\n"
+            ".sas-table tbody tr:first-child td,\n"
+            "table.table tbody tr:first-child th,\n"
+            "table.table tbody tr:first-child td {\n"
+            "  border-top: 2px solid currentcolor;\n"
+            "}\n"
+            "/* Midrule: after header rows (rows with .header class) */\n"
+            ".sas-table tbody tr:has(.header) + tr:not(:has(.header)) td,\n"
+            ".sas-table tbody tr:has(.header) + tr:not(:has(.header)) th,\n"
+            "table.table tbody tr:has(.header) + tr:not(:has(.header)) td,\n"
+            "table.table tbody tr:has(.header) + tr:not(:has(.header)) th {\n"
+            "  border-top: 1px solid currentcolor;\n"
+            "}\n"
+            "/* Bottomrule: last row */\n"
+            ".sas-table tbody tr:last-child td,\n"
+            ".sas-table tbody tr:last-child th,\n"
+            "table.table tbody tr:last-child td,\n"
+            "table.table tbody tr:last-child th {\n"
+            "  border-bottom: 2px solid currentcolor;\n"
+            "}\n"
+            "</style>\n";
+    }
+
     interpreter::interpreter()
-        : m_session(nullptr)
+        : m_sessions(nullptr)
         , m_completer(nullptr)
         , m_inspector(nullptr)
+        , m_stopping(false)
     {
         // Initialization will happen in configure_impl()
     }
 
     interpreter::~interpreter()
     {
-        // Cleanup handled by unique_ptr
+        stop_interrupt_watcher();
+
+        // Dropped cells are answered through m_publish_mutex, so the
+        // sessions must go down before the other members
+        if (m_sessions)
+        {
+            m_sessions->shutdown();
+        }
+    }
+
+    void interpreter::watch_interrupts()
+    {
+        std::vector<poll_event> events;
+        while (!m_stopping)
+        {
+            m_interrupt_poller->wait(events, -1);
+
+            // Drain the self-pipe; one restart covers any number of signals
+            char tokens[64];
+            while (read(g_interrupt_fd, tokens, sizeof(tokens)) > 0)
+            {
+            }
+
+            if (!m_stopping && g_interrupt_requested.exchange(false, std::memory_order_acquire))
+            {
+                handle_interrupt();
+            }
+        }
+    }
+
+    void interpreter::stop_interrupt_watcher()
+    {
+        if (m_interrupt_watcher.joinable())
+        {
+            m_stopping = true;
+            m_interrupt_poller->wake();
+            m_interrupt_watcher.join();
+        }
     }
 
     void interpreter::handle_interrupt()
     {
+        // The watcher and the next execute request may both see the flag
+        std::lock_guard<std::mutex> interrupt_lock(m_interrupt_mutex);
         std::cerr << "\n=== INTERRUPT HANDLER CALLED ===" << std::endl;
 
-        if (m_session)
+        if (m_sessions)
         {
-            std::cerr << "Restarting SAS session due to interrupt..." << std::endl;
-
-            // Restart the SAS session (shutdown + reinitialize)
-            // This is necessary because SAS running in batch mode (-stdio)
-            // does not support graceful interruption. SIGINT would kill the
-            // child SAS process, breaking the kernel connection.
-            m_session->restart();
-
-            std::cerr << "=== SAS SESSION RESTARTED ===" << std::endl;
-            std::cerr << "WARNING: Session state lost (datasets, macro variables cleared)" << std::endl;
-            std::cerr << "=================================" << std::endl;
-
-            // Publish warning to user via stderr stream
-            publish_stream("stderr",
-                "\n⚠️  Kernel interrupted - SAS session restarted\n"
-                "    Session state has been lost (WORK datasets, macro variables)\n"
-                "    You can continue using the kernel normally.\n"
-            );
+            std::cerr << "Restarting busy SAS sessions due to interrupt..." << std::endl;
+
+            for (const auto& name : m_sessions->names())
+            {
+                // Idle sessions keep their state: only one with a cell
+                // running or queued has anything to interrupt
+                if (!m_sessions->busy(name))
+                {
+                    continue;
+                }
+
+                // Abort running and queued cells, then restart the session
+                // (shutdown + reinitialize).
+                // This is necessary because SAS running in batch mode (-stdio)
+                // does not support graceful interruption. SIGINT would kill the
+                // child SAS process, breaking the kernel connection.
+                sas_session& session = m_sessions->get(name);
+                session.interrupt();
+                session.restart();
+
+                std::cerr << "=== SAS SESSION '" << name << "' RESTARTED ===" << std::endl;
+                std::cerr << "=================================" << std::endl;
+
+                // Publish warning to user via stderr stream
+                std::string label = (name == default_session_name) ? "" : " '" + name + "'";
+                std::string state = session.has_checkpoint()
+                    ? "    WORK datasets and macro variables will be restored from the last checkpoint\n"
+                    : "    Session state has been lost (WORK datasets, macro variables)\n";
+                std::lock_guard<std::mutex> lock(m_publish_mutex);
+                publish_stream("stderr",
+                    "\n⚠️  Kernel interrupted - SAS session" + label + " restarted\n" + state +
+                    "    You can continue using the kernel normally.\n"
+                );
+            }
         }
         else
         {
@@ -61,12 +161,23 @@ namespace xeus_sas
 
     void interpreter::configure_impl()
     {
-        // Initialize SAS session
-        m_session = std::make_unique<sas_session>();
+        // Create the default SAS session; it starts right away, so its
+        // startup overlaps with the frontend connecting instead of delaying
+        // the first cell. Further sessions are created by %%session.
+        m_sessions = std::make_unique<session_manager>();
+        sas_session& session = m_sessions->get(default_session_name);
 
         // Initialize completion and inspection engines
-        m_completer = std::make_unique<completion_engine>(m_session.get());
-        m_inspector = std::make_unique<inspection_engine>(m_session.get());
+        m_completer = std::make_unique<completion_engine>(&session);
+        m_inspector = std::make_unique<inspection_engine>(&session);
+
+        // Handle SIGINT while a cell is running instead of at the next request
+        if (g_interrupt_fd >= 0)
+        {
+            m_interrupt_poller = std::make_unique<event_poller>();
+            m_interrupt_poller->add(g_interrupt_fd, true);
+            m_interrupt_watcher = std::thread(&interpreter::watch_interrupts, this);
+        }
     }
 
     void interpreter::execute_request_impl(
@@ -77,15 +188,148 @@ namespace xeus_sas
         nl::json user_expressions
     )
     {
-        // Check if interrupt was requested before execution
+        // Interrupts are normally handled by the watcher as they arrive;
+        // without the self-pipe they are picked up here, before new code
         if (g_interrupt_requested.exchange(false, std::memory_order_acquire))
         {
-            // Handle interrupt before executing new code
             handle_interrupt();
         }
 
-        // Execute code in SAS session
-        auto result = m_session->execute(code);
+        // Pick the target session and limits from optional cell magics
+        cell_target target;
+        try
+        {
+            target = parse_cell_magics(code);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            nl::json response;
+            response["status"] = "error";
+            response["ename"] = "Magic Error";
+            response["evalue"] = e.what();
+            response["traceback"] = nl::json::array({e.what()});
+
+            std::lock_guard<std::mutex> lock(m_publish_mutex);
+            if (!config.silent)
+            {
+                publish_stream("stderr", std::string(e.what()) + "\n");
+            }
+            cb(response);
+            return;
+        }
+
+        // Stream output to the frontend while SAS is still running: each ODS
+        // output object is displayed as soon as it is complete. Live log lines
+        // are opt-in (XEUS_SAS_STREAM_LOG=1) because the log is normally shown
+        // only when there is no richer output.
+        const char* stream_log_env = std::getenv("XEUS_SAS_STREAM_LOG");
+        bool stream_log = stream_log_env && std::string(stream_log_env) != "0";
+        auto streamed_log = std::make_shared<std::atomic<bool>>(false);
+
+        // Output is published after this returns, when xeus may already be
+        // handling a later request; it goes out against this one's header
+        auto parent = std::make_shared<const nl::json>(parent_header());
+
+        bool silent = config.silent;
+        auto on_output = [this, silent, stream_log, streamed_log, parent](const output_chunk& chunk)
+        {
+            if (silent)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_publish_mutex);
+            publish_parent_scope scope(*parent);
+            switch (chunk.kind)
+            {
+                case output_kind::html:
+                {
+                    // Display rich HTML output using display_data
+                    // Inject booktabs-style CSS for tables
+                    nl::json html_data;
+                    html_data["text/html"] = std::string(table_style) + chunk.text;
+                    display_data(std::move(html_data), nl::json::object(), nl::json::object());
+                    break;
+                }
+                case output_kind::graph:
+                    display_graphics({chunk.text});
+                    break;
+                case output_kind::notice:
+                    publish_stream("stderr", chunk.text);
+                    break;
+                case output_kind::log:
+                    if (stream_log)
+                    {
+                        publish_stream("stdout", colorize_log(chunk.text));
+                        *streamed_log = true;
+                    }
+                    break;
+            }
+        };
+
+        // Write the cell to SAS right away, so SAS works on it while earlier
+        // cells of the same session are still being formatted
+        std::shared_future<execution_result> pending;
+        try
+        {
+            pending = m_sessions->get(target.session)
+                          .submit(target.code, on_output, target.limits, target.checkpoint)
+                          .share();
+        }
+        catch (const std::exception& e)
+        {
+            nl::json response;
+            response["status"] = "error";
+            response["ename"] = "SAS Error";
+            response["evalue"] = e.what();
+            response["traceback"] = nl::json::array({e.what()});
+
+            std::lock_guard<std::mutex> lock(m_publish_mutex);
+            if (!config.silent)
+            {
+                publish_stream("stderr", std::string(e.what()) + "\n");
+            }
+            cb(response);
+            return;
+        }
+
+        // Reply from the session's worker thread once the result is in, so
+        // cells for different sessions execute concurrently
+        m_sessions->submit(target.session,
+            [this, cb, execution_counter, pending, streamed_log, config, user_expressions, parent](sas_session& session)
+            {
+                publish_parent_scope scope(*parent);
+                publish_result(cb, execution_counter, pending.get(), *streamed_log, config, user_expressions);
+
+                // Checkpoint while the session is idle, unless the next cell
+                // already took it before reaching SAS
+                session.take_due_checkpoint();
+            },
+            [this, cb]()
+            {
+                // The kernel is shutting down before this cell's turn came
+                nl::json response;
+                response["status"] = "error";
+                response["ename"] = "Kernel Shutdown";
+                response["evalue"] = "The kernel shut down before the cell ran";
+                response["traceback"] = nl::json::array({"The kernel shut down before the cell ran"});
+
+                std::lock_guard<std::mutex> lock(m_publish_mutex);
+                cb(response);
+            });
+    }
+
+    void interpreter::publish_result(
+        xeus::xinterpreter::send_reply_callback cb,
+        int execution_counter,
+        const execution_result& result,
+        bool streamed_log,
+        xeus::execute_request_config config,
+        nl::json user_expressions
+    )
+    {
+        // Publishing from several session workers must not interleave
+        std::lock_guard<std::mutex> lock(m_publish_mutex);
 
         // Prepare response
         nl::json response;
@@ -98,7 +342,7 @@ namespace xeus_sas
             response["evalue"] = result.error_message;
             response["traceback"] = nl::json::array({result.log});
 
-            if (!config.silent)
+            if (!config.silent && !streamed_log)
             {
                 publish_stream("stderr", colorize_log(result.log));
             }
@@ -109,177 +353,112 @@ namespace xeus_sas
             response["status"] = "ok";
             response["execution_count"] = execution_counter;
 
-            if (!config.silent)
+            // HTML output and graphics were displayed while streaming; otherwise
+            // fall back to plain text output
+            if (!config.silent && !result.has_html)
             {
-                // Check if we have HTML output
-                if (result.has_html && !result.html_output.empty())
+                // Determine what to display
+                if (should_show_listing(result))
                 {
-                    // === DEBUG LOGGING: HTML BEING SENT ===
-                    std::cerr << "=== XINTERPRETER: HTML DEBUG INFO ===" << std::endl;
-                    std::cerr << "HTML Length: " << result.html_output.length() << std::endl;
-                    std::cerr << "First 300 chars: " << result.html_output.substr(0, 300) << std::endl;
-                    if (result.html_output.length() > 300)
-                    {
-                        size_t start = result.html_output.length() > 300 ? result.html_output.length() - 300 : 0;
-                        std::cerr << "Last 300 chars: " << result.html_output.substr(start) << std::endl;
-                    }
-                    std::cerr << "Contains <!DOCTYPE: " << (result.html_output.find("<!DOCTYPE") != std::string::npos) << std::endl;
-                    std::cerr << "Contains </html>: " << (result.html_output.find("</html>") != std::string::npos) << std::endl;
-                    std::cerr << "Starts with <!DOCTYPE: " << (result.html_output.substr(0, 15) == "<!DOCTYPE html>") << std::endl;
-                    std::cerr << "Ends with </html>: " << (result.html_output.length() >= 7 && result.html_output.substr(result.html_output.length()-7) == "</html>") << std::endl;
-
-                    // Count table rows
-                    size_t tr_count = 0;
-                    size_t pos = 0;
-                    while ((pos = result.html_output.find("</tr>", pos)) != std::string::npos)
-                    {
-                        tr_count++;
-                        pos += 5;
-                    }
-                    std::cerr << "Number of </tr> tags: " << tr_count << std::endl;
-
-                    // Check for table structure
-                    std::cerr << "Contains <table: " << (result.html_output.find("<table") != std::string::npos) << std::endl;
-                    std::cerr << "Contains </table>: " << (result.html_output.find("</table>") != std::string::npos) << std::endl;
-                    std::cerr << "Contains <colgroup>: " << (result.html_output.find("<colgroup>") != std::string::npos) << std::endl;
-                    std::cerr << "Contains <thead>: " << (result.html_output.find("<thead>") != std::string::npos) << std::endl;
-                    std::cerr << "Contains <tbody>: " << (result.html_output.find("<tbody>") != std::string::npos) << std::endl;
-                    std::cerr << "======================================" << std::endl;
-
-                    // Display rich HTML output using display_data
-                    // Inject booktabs-style CSS for tables
-                    std::string styled_output = "<style>\n"
-                        ".sas-table, .sas-table table, table.table {\n"
-                        "  border-collapse: collapse;\n"
-                        "  border: none;\n"
-                        "}\n"
-                        ".sas-table td, .sas-table th,\n"
-                        "table.table td, table.table th {\n"
-                        "  border: none;\n"
-                        "  padding: 4px 8px;\n"
-                        "}\n"
-                        "/* Toprule: first row with headers */\n"
-                        ".sas-table tbody tr:first-child th,\n"
-                        ".sas-table tbody tr:first-child td,\n"
-                        "table.table tbody tr:first-child th,\n"
-                        "table.table tbody tr:first-child td {\n"
-                        "  border-top: 2px solid currentcolor;\n"
-                        "}\n"
-                        "/* Midrule: after header rows (rows with .header class) */\n"
-                        ".sas-table tbody tr:has(.header) + tr:not(:has(.header)) td,\n"
-                        ".sas-table tbody tr:has(.header) + tr:not(:has(.header)) th,\n"
-                        "table.table tbody tr:has(.header) + tr:not(:has(.header)) td,\n"
-                        "table.table tbody tr:has(.header) + tr:not(:has(.header)) th {\n"
-                        "  border-top: 1px solid currentcolor;\n"
-                        "}\n"
-                        "/* Bottomrule: last row */\n"
-                        ".sas-table tbody tr:last-child td,\n"
-                        ".sas-table tbody tr:last-child th,\n"
-                        "table.table tbody tr:last-child td,\n"
-                        "table.table tbody tr:last-child th {\n"
-                        "  border-bottom: 2px solid currentcolor;\n"
-                        "}\n"
-                        "</style>\n";
-                    styled_output += result.html_output;
-
-                    nl::json html_data;
-                    html_data["text/html"] = styled_output;
-
-                    // Also include plain text fallback (log)
-                    if (!result.log.empty())
+                    // Show listing output with theme-adaptive styling
+                    if (!result.listing.empty())
                     {
-                        html_data["text/plain"] = result.log;
-                    }
+                        // Strip framing sentinels from listing
+                        std::string clean_listing = result.listing;
+                        std::regex marker_regex(R"(XEUS_SAS_MARKER_[0-9a-f]+_(BEGIN|END)\s*)");
+                        clean_listing = std::regex_replace(clean_listing, marker_regex, "");
 
-                    // Debug: Check what's in the JSON
-                    std::cerr << "=== JSON DEBUG INFO ===" << std::endl;
-                    std::cerr << "JSON has text/html key: " << html_data.contains("text/html") << std::endl;
-                    if (html_data.contains("text/html"))
-                    {
-                        std::string json_html = html_data["text/html"].get<std::string>();
-                        std::cerr << "JSON text/html length: " << json_html.length() << std::endl;
-                        std::cerr << "JSON text/html matches result.html_output: " << (json_html == result.html_output) << std::endl;
-                    }
-                    std::cerr << "=======================" << std::endl;
+                        // Trim trailing whitespace
+                        clean_listing.erase(clean_listing.find_last_not_of(" \n\r\t") + 1);
 
-                    display_data(html_data, nl::json::object(), nl::json::object());
-                }
-                else
-                {
-                    // Fallback to plain text output
-                    // Determine what to display
-                    if (should_show_listing(result))
-                    {
-                        // Show listing output with theme-adaptive styling
-                        if (!result.listing.empty())
+                        if (!clean_listing.empty())
                         {
-                            // Strip XEUS_SAS_END markers from listing
-                            std::string clean_listing = result.listing;
-                            std::regex marker_regex(R"(XEUS_SAS_END_\d+\s*)");
-                            clean_listing = std::regex_replace(clean_listing, marker_regex, "");
-
-                            // Trim trailing whitespace
-                            clean_listing.erase(clean_listing.find_last_not_of(" \n\r\t") + 1);
-
-                            if (!clean_listing.empty())
+                            // Wrap in styled HTML for consistent appearance
+                            std::string styled_html = "<style>\n"
+                                ".sas-listing {\n"
+                                "  font-family: ui-monospace, 'Cascadia Code', 'Source Code Pro', Menlo, 'DejaVu Sans Mono', Consolas, monospace;\n"
+                                "  font-size: 12px;\n"
+                                "  font-variant-ligatures: none;\n"
+                                "  color: inherit;\n"
+                                "  background-color: transparent;\n"
+                                "  padding: 10px;\n"
+                                "  border: 1px solid currentcolor;\n"
+                                "  border-radius: 3px;\n"
+                                "  opacity: 0.6;\n"
+                                "  overflow-x: auto;\n"
+                                "  margin: 0;\n"
+                                "  line-height: 1.4;\n"
+                                "  white-space: pre;\n"
+                                "}\n"
+                                "</style>\n"
+                                "<pre class=\"sas-listing\">";
+
+                            // HTML escape the listing content
+                            for (char c : clean_listing)
                             {
-                                // Wrap in styled HTML for consistent appearance
-                                std::string styled_html = "<style>\n"
-                                    ".sas-listing {\n"
-                                    "  font-family: ui-monospace, 'Cascadia Code', 'Source Code Pro', Menlo, 'DejaVu Sans Mono', Consolas, monospace;\n"
-                                    "  font-size: 12px;\n"
-                                    "  font-variant-ligatures: none;\n"
-                                    "  color: inherit;\n"
-                                    "  background-color: transparent;\n"
-                                    "  padding: 10px;\n"
-                                    "  border: 1px solid currentcolor;\n"
-                                    "  border-radius: 3px;\n"
-                                    "  opacity: 0.6;\n"
-                                    "  overflow-x: auto;\n"
-                                    "  margin: 0;\n"
-                                    "  line-height: 1.4;\n"
-                                    "  white-space: pre;\n"
-                                    "}\n"
-                                    "</style>\n"
-                                    "<pre class=\"sas-listing\">";
-
-                                // HTML escape the listing content
-                                for (char c : clean_listing)
+                                switch (c)
                                 {
-                                    switch (c)
-                                    {
-                                        case '<': styled_html += "&lt;"; break;
-                                        case '>': styled_html += "&gt;"; break;
-                                        case '&': styled_html += "&amp;"; break;
-                                        default: styled_html += c;
-                                    }
+                                    case '<': styled_html += "&lt;"; break;
+                                    case '>': styled_html += "&gt;"; break;
+                                    case '&': styled_html += "&amp;"; break;
+                                    default: styled_html += c;
                                 }
-                                styled_html += "</pre>";
-
-                                nl::json html_data;
-                                html_data["text/html"] = styled_html;
-                                html_data["text/plain"] = clean_listing;
-                                publish_execution_result(execution_counter, std::move(html_data), nl::json::object());
                             }
+                            styled_html += "</pre>";
+
+                            nl::json html_data;
+                            html_data["text/html"] = styled_html;
+                            html_data["text/plain"] = clean_listing;
+                            publish_execution_result(execution_counter, std::move(html_data), nl::json::object());
                         }
                     }
-                    else
+                }
+                else
+                {
+                    // Show log (for debugging or when no listing)
+                    if (!result.log.empty() && !streamed_log)
                     {
-                        // Show log (for debugging or when no listing)
-                        if (!result.log.empty())
-                        {
-                            publish_stream("stdout", colorize_log(result.log));
-                        }
+                        publish_stream("stdout", colorize_log(result.log));
                     }
                 }
+            }
+        }
 
-                // Display graphics if any
-                if (!result.graph_files.empty())
-                {
-                    display_graphics(result.graph_files);
-                }
+        // What the cell cost SAS. xeus builds the execute_reply metadata
+        // itself, so the numbers travel in the reply content.
+        const resource_usage& usage = result.resources;
+        nl::json resources;
+        resources["available"] = usage.available;
+        resources["wall_ms"] = result.sas_time_ms;
+        resources["drain_ms"] = result.drain_time_ms;
+        if (usage.available)
+        {
+            resources["cpu_user_s"] = usage.cpu_user_s;
+            resources["cpu_system_s"] = usage.cpu_system_s;
+            resources["peak_rss_kb"] = usage.peak_rss_kb;
+            resources["peak_rss_scope"] = usage.peak_rss_per_cell ? "cell" : "session";
+            resources["voluntary_ctxt_switches"] = usage.voluntary_switches;
+            resources["involuntary_ctxt_switches"] = usage.involuntary_switches;
+            if (usage.has_io)
+            {
+                resources["read_chars"] = usage.read_chars;
+                resources["write_chars"] = usage.write_chars;
+                resources["read_bytes"] = usage.read_bytes;
+                resources["write_bytes"] = usage.write_bytes;
             }
         }
+        response["sas_resources"] = resources;
+
+        // Optional one-line footer under the cell output
+        const char* footer_env = std::getenv("XEUS_SAS_RESOURCE_FOOTER");
+        if (!config.silent && footer_env && std::string(footer_env) != "0")
+        {
+            std::string footer = format_usage(usage, result.sas_time_ms);
+            nl::json footer_data;
+            footer_data["text/plain"] = footer;
+            footer_data["text/html"] = "<div style=\"font-size: 11px; opacity: 0.6;\">" + footer + "</div>";
+            display_data(std::move(footer_data), nl::json::object(), nl::json::object());
+        }
 
         // Handle user expressions (if any)
         if (!user_expressions.is_null())
@@ -437,9 +616,10 @@ namespace xeus_sas
 
     void interpreter::shutdown_request_impl()
     {
-        if (m_session)
+        stop_interrupt_watcher();
+        if (m_sessions)
         {
-            m_session->shutdown();
+            m_sessions->shutdown();
         }
     }
 
@@ -0,0 +1,62 @@
+#ifndef XEUS_SAS_TEST_TEMP_DIRECTORY_HPP
+#define XEUS_SAS_TEST_TEMP_DIRECTORY_HPP
+
+#include <gtest/gtest.h>
+#include "xeus-sas/work_checkpoint.hpp"
+
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace xeus_sas
+{
+    /**
+     * @brief Create a fresh directory /tmp/<prefix>XXXXXX
+     * @return Its path, or an empty string if mkdtemp failed
+     */
+    inline std::string make_temp_directory(const std::string& prefix)
+    {
+        std::string pattern = "/tmp/" + prefix + "XXXXXX";
+        std::vector<char> buffer(pattern.begin(), pattern.end());
+        buffer.push_back('\0');
+        return mkdtemp(buffer.data()) ? std::string(buffer.data()) : std::string();
+    }
+
+    /**
+     * @brief Fixture owning a temporary directory for each test
+     *
+     * The directory is created before and removed (with its contents)
+     * after every test. Fixtures that override SetUp() call this one first.
+     */
+    class TempDirectoryTest : public ::testing::Test
+    {
+    protected:
+        explicit TempDirectoryTest(const char* prefix)
+            : m_prefix(prefix)
+        {
+        }
+
+        void SetUp() override
+        {
+            root = make_temp_directory(m_prefix);
+            ASSERT_FALSE(root.empty()) << "mkdtemp failed for " << m_prefix;
+        }
+
+        void TearDown() override
+        {
+            if (!root.empty())
+            {
+                remove_tree(root);
+            }
+        }
+
+        std::string root;
+
+    private:
+        std::string m_prefix;
+    };
+
+} // namespace xeus_sas
+
+#endif // XEUS_SAS_TEST_TEMP_DIRECTORY_HPP
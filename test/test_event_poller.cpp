@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/event_poller.hpp"
+
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+using namespace xeus_sas;
+
+TEST(EventPollerTest, TimeoutWithoutEvents)
+{
+    event_poller poller;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    poller.add(fds[0], true);
+
+    std::vector<poll_event> events;
+    bool woken = poller.wait(events, 10);
+
+    EXPECT_FALSE(woken);
+    EXPECT_TRUE(events.empty());
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(EventPollerTest, ReportsReadableDescriptor)
+{
+    event_poller poller;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    poller.add(fds[0], true);
+
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+
+    std::vector<poll_event> events;
+    poller.wait(events, 1000);
+
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].fd, fds[0]);
+    EXPECT_TRUE(events[0].readable);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(EventPollerTest, ReportsHangup)
+{
+    event_poller poller;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    poller.add(fds[0], true);
+    close(fds[1]);
+
+    std::vector<poll_event> events;
+    poller.wait(events, 1000);
+
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_TRUE(events[0].hangup);
+
+    close(fds[0]);
+}
+
+TEST(EventPollerTest, WakeAbortsWait)
+{
+    event_poller poller;
+    std::thread waker([&poller]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        poller.wake();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<poll_event> events;
+    bool woken = poller.wait(events, 10000);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    waker.join();
+
+    EXPECT_TRUE(woken);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+
+    // The wakeup is consumed
+    EXPECT_FALSE(poller.wait(events, 10));
+}
+
+TEST(EventPollerTest, RemovedDescriptorIsIgnored)
+{
+    event_poller poller;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    poller.add(fds[0], true);
+    poller.remove(fds[0]);
+
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+
+    std::vector<poll_event> events;
+    poller.wait(events, 10);
+    EXPECT_TRUE(events.empty());
+
+    close(fds[0]);
+    close(fds[1]);
+}
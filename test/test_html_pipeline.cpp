@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/html_pipeline.hpp"
+#include "xeus-sas/html_postprocess.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace xeus_sas;
+
+namespace
+{
+    // One output object per BY group; later ones are bigger so that they
+    // tend to finish after the small ones queued behind them
+    std::vector<std::string> by_group_blocks(size_t count)
+    {
+        std::vector<std::string> blocks;
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string block = "<div style=\"padding-bottom: 8px\"><table class=\"table\" style=\"border-spacing: 0\">"
+                                "<thead><tr><th class=\"header\" scope=\"col\">group " + std::to_string(i) +
+                                "</th></tr></thead><tbody>";
+            size_t rows = (i % 3 == 0) ? 2000 : 1;
+            for (size_t row = 0; row < rows; ++row)
+            {
+                block += "<tr><td class=\"data\" rowspan=\"1\">" + std::to_string(row) + "</td></tr>";
+            }
+            blocks.push_back(block + "</tbody></table></div>");
+        }
+        return blocks;
+    }
+}
+
+TEST(HtmlPipelineTest, PublishesBlocksInOrder)
+{
+    std::vector<std::string> blocks = by_group_blocks(30);
+    std::atomic<size_t> ready(0);
+    html_pipeline pipeline(3, [&ready] { ++ready; });
+
+    for (const auto& block : blocks)
+    {
+        pipeline.push(block);
+    }
+    EXPECT_TRUE(pipeline.pending());
+
+    std::string html;
+    for (const auto& block : blocks)
+    {
+        ASSERT_TRUE(pipeline.wait_pop(html));
+        EXPECT_EQ(html, clean_ods_html(block));
+    }
+    EXPECT_FALSE(pipeline.pending());
+    EXPECT_FALSE(pipeline.pop(html));
+    EXPECT_FALSE(pipeline.wait_pop(html));
+    EXPECT_EQ(ready.load(), blocks.size());
+}
+
+TEST(HtmlPipelineTest, CleansInlineWithoutWorkers)
+{
+    std::vector<std::string> blocks = by_group_blocks(2);
+    html_pipeline pipeline(0);
+    pipeline.push(blocks[0]);
+    pipeline.push(blocks[1]);
+
+    // Nothing to wait for: push() already did the work
+    std::string html;
+    ASSERT_TRUE(pipeline.pop(html));
+    EXPECT_EQ(html, clean_ods_html(blocks[0]));
+    ASSERT_TRUE(pipeline.pop(html));
+    EXPECT_EQ(html, clean_ods_html(blocks[1]));
+    EXPECT_FALSE(pipeline.pop(html));
+}
+
+TEST(HtmlPipelineTest, PublishesRawBlockWhenCleaningFails)
+{
+    auto failing = [](const std::string&) -> std::string { throw std::runtime_error("bad markup"); };
+    for (size_t workers : {size_t(0), size_t(2)})
+    {
+        html_pipeline pipeline(workers);
+        pipeline.push("<p>raw</p>", failing);
+
+        std::string html;
+        ASSERT_TRUE(pipeline.wait_pop(html));
+        EXPECT_EQ(html, "<p>raw</p>");
+    }
+}
+
+TEST(HtmlPipelineTest, StopsWithBlocksQueued)
+{
+    std::vector<std::string> blocks = by_group_blocks(20);
+    html_pipeline pipeline(1);
+    for (const auto& block : blocks)
+    {
+        pipeline.push(block);
+    }
+    // Destruction must not wait for or trip over the unfinished blocks
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/html_postprocess.hpp"
+
+using namespace xeus_sas;
+
+namespace
+{
+    // One PROC PRINT output object as emitted by ODS HTML5 (no_top_matter)
+    const std::string print_block =
+        "<div style=\"padding-bottom: 8px; padding-top: 1px\">\n"
+        "<table class=\"table\" style=\"border-spacing: 0\" aria-label=\"Data Set WORK.TEST\">\n"
+        "<caption aria-label=\"Data Set WORK.TEST\"></caption>\n"
+        "<colgroup><col/></colgroup><colgroup><col/><col/></colgroup>\n"
+        "<thead>\n<tr>\n"
+        "<th class=\"r header\" scope=\"col\">Obs</th>\n"
+        "<th class=\"header\" scope=\"col\">name</th>\n"
+        "<th class=\"r header\" scope=\"col\">age</th>\n"
+        "</tr>\n</thead>\n"
+        "<tbody>\n<tr>\n"
+        "<th class=\"r rowheader\" scope=\"row\">1</th>\n"
+        "<td class=\"data\">Alice</td>\n"
+        "<td class=\"r data\">25</td>\n"
+        "</tr>\n</tbody>\n</table>\n</div>";
+
+    // PROC TABULATE header with rowspan/colspan
+    const std::string tabulate_block =
+        "<div><table class=\"table\"><thead>"
+        "<tr><th class=\"c header\" rowspan=\"2\" scope=\"col\">&#160;</th>"
+        "<th class=\"c header\" colspan=\"2\" scope=\"colgroup\">sex</th></tr>"
+        "<tr><th class=\"c header\" scope=\"col\">F</th><th class=\"c header\" scope=\"col\">M</th></tr>"
+        "</thead><tbody>"
+        "<tr><th class=\"t rowheader\" scope=\"row\">N</th>"
+        "<td class=\"r data\">9</td><td class=\"r data\">10</td></tr>"
+        "</tbody></table></div>";
+}
+
+TEST(HtmlPostprocessTest, CleansProcPrintBlock)
+{
+    std::string expected =
+        "<div>\n"
+        "<table class=\"table\"><tbody>"
+        "<tr><th class=\"r header\" scope=\"col\">Obs</th><th class=\"header\" scope=\"col\">name</th>"
+        "<th class=\"r header\" scope=\"col\">age</th></tr>"
+        "<tr><th class=\"r rowheader\" scope=\"row\">1</th><td class=\"data\">Alice</td>"
+        "<td class=\"r data\">25</td></tr>"
+        "</tbody></table>\n"
+        "</div>";
+
+    EXPECT_EQ(clean_ods_html(print_block), expected);
+}
+
+TEST(HtmlPostprocessTest, FlattensRowspanAndColspan)
+{
+    std::string expected =
+        "<div><table class=\"table\"><tbody>"
+        "<tr><td>&#160;</td><th class=\"c header\" scope=\"colgroup\">sex</th>"
+        "<th class=\"c header\" scope=\"colgroup\">sex</th></tr>"
+        "<tr><th class=\"c header\" scope=\"col\">&#160;</th><th class=\"c header\" scope=\"col\">F</th>"
+        "<th class=\"c header\" scope=\"col\">M</th></tr>"
+        "<tr><th class=\"t rowheader\" scope=\"row\">N</th><td class=\"r data\">9</td>"
+        "<td class=\"r data\">10</td></tr>"
+        "</tbody></table></div>";
+
+    EXPECT_EQ(clean_ods_html(tabulate_block), expected);
+}
+
+TEST(HtmlPostprocessTest, RemovesTitleContainer)
+{
+    std::string title =
+        "<div id=\"IDX\" class=\"systitleandfootercontainer\" style=\"border-spacing: 1px\">\n"
+        "<p><span class=\"c systemtitle\">The SAS System</span> </p>\n"
+        "</div>";
+
+    EXPECT_EQ(clean_ods_html(title), "");
+}
+
+TEST(HtmlPostprocessTest, StripsStyleAndAriaAttributes)
+{
+    std::string html = "<div style=\"padding: 1px\"><p aria-label=\"note\">text</p></div>";
+
+    EXPECT_EQ(clean_ods_html(html), "<div><p>text</p></div>");
+}
+
+TEST(HtmlPostprocessTest, RewritesEveryTableOfABlock)
+{
+    std::string html =
+        "<div><table class=\"table\"><tbody><tr><td>1</td></tr></tbody></table></div>\n"
+        "<div><table class=\"table\" style=\"border-spacing: 0\">"
+        "<caption aria-label=\"Means\">Analysis Variable : age</caption>"
+        "<caption> </caption>"
+        "<colgroup><col/></colgroup>\n<colgroup><col/><col/></colgroup>"
+        "<thead><tr><th>N</th></tr></thead>\n<tbody><tr><td>19</td></tr></tbody></table></div>";
+    std::string expected =
+        "<div><table class=\"table\"><tbody><tr><td>1</td></tr></tbody></table></div>\n"
+        "<div><table class=\"table\"><tbody><tr><th>N</th></tr><tr><td>19</td></tr></tbody></table></div>";
+
+    EXPECT_EQ(clean_ods_html(html), expected);
+}
+
+TEST(HtmlPostprocessTest, FlattensEveryByGroupTable)
+{
+    // PROC TABULATE with a BY statement: one table per BY group
+    std::string html = tabulate_block + "\n" + tabulate_block + "\n" + tabulate_block;
+    std::string flat = clean_ods_html(tabulate_block);
+
+    EXPECT_EQ(clean_ods_html(html), flat + "\n" + flat + "\n" + flat);
+    EXPECT_EQ(flat.find("span="), std::string::npos);
+}
+
+TEST(HtmlPostprocessTest, KeepsCellsOverlappedBySpans)
+{
+    // The second row's colspan runs into the column held by the rowspan
+    // above; the later cell wins there, and the rowspan still blocks row 3
+    std::string html =
+        "<table><tr><td>a</td><td rowspan=\"3\">b</td></tr>"
+        "<tr><td colspan=\"2\">c</td></tr>"
+        "<tr><td>d</td></tr></table>";
+    std::string expected =
+        "<table class=\"table\"><tbody>"
+        "<tr><td>a</td><td>&#160;</td></tr>"
+        "<tr><td>c</td><td>c</td></tr>"
+        "<tr><td>d</td><td>b</td></tr>"
+        "</tbody></table>";
+
+    EXPECT_EQ(clean_ods_html(html), expected);
+}
+
+TEST(HtmlPostprocessTest, LeavesAttributeLikeTextAlone)
+{
+    // Attributes are only stripped inside tags, not from cell text
+    std::string html = "<p class=\"note\">Set style=\"x\" in the template</p>";
+
+    EXPECT_EQ(clean_ods_html(html), html);
+}
+
+TEST(HtmlPostprocessTest, PassesCompactMarkupThrough)
+{
+    // As written by tagsets.xeus_sas for PROC PRINT
+    const std::string block =
+        "<div class=\"xeus-sas-output\">\n<table class=\"table\"><tbody>\n"
+        "<tr><th class=\"r header\">Obs</th><th class=\"header\">name</th></tr>\n"
+        "<tr><th class=\"r rowheader\">1</th><td class=\"data\">Alice</td></tr>\n"
+        "</tbody></table>\n</div>\n";
+    EXPECT_EQ(normalize_compact_html(block), block);
+}
+
+TEST(HtmlPostprocessTest, FlattensSpansInCompactMarkup)
+{
+    const std::string block =
+        "<div class=\"xeus-sas-output\">\n<table class=\"table\"><tbody>\n"
+        "<tr><th class=\"c header\" rowspan=\"2\">&#160;</th><th class=\"c header\" colspan=\"2\">sex</th></tr>\n"
+        "<tr><th class=\"c header\">F</th><th class=\"c header\">M</th></tr>\n"
+        "</tbody></table>\n</div>\n";
+    std::string html = normalize_compact_html(block);
+
+    EXPECT_EQ(html.find("span="), std::string::npos);
+    EXPECT_EQ(html, clean_ods_html(block));
+}
+
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/launch_profile.hpp"
+#include "xeus-sas/work_checkpoint.hpp"
+#include "temp_directory.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+using namespace xeus_sas;
+
+namespace
+{
+    class LaunchProfileTest : public TempDirectoryTest
+    {
+    protected:
+        LaunchProfileTest()
+            : TempDirectoryTest("xeus_sas_profile_")
+        {
+        }
+
+        void write(const std::string& relative, const std::string& content)
+        {
+            std::string path = root + "/" + relative;
+            make_directories(path.substr(0, path.find_last_of('/')));
+            std::ofstream(path) << content;
+        }
+    };
+}
+
+TEST(LaunchProfileParseTest, ParsesCpuMax)
+{
+    double cpus = 0.0;
+    ASSERT_TRUE(parse_cpu_max("250000 100000\n", cpus));
+    EXPECT_DOUBLE_EQ(cpus, 2.5);
+    EXPECT_FALSE(parse_cpu_max("max 100000", cpus));
+    EXPECT_FALSE(parse_cpu_max("", cpus));
+
+    ASSERT_TRUE(parse_cfs_quota("50000", "100000", cpus));
+    EXPECT_DOUBLE_EQ(cpus, 0.5);
+    EXPECT_FALSE(parse_cfs_quota("-1", "100000", cpus));
+}
+
+TEST(LaunchProfileParseTest, ParsesMemoryLimit)
+{
+    unsigned long long bytes = 0;
+    ASSERT_TRUE(parse_memory_limit("4294967296\n", bytes));
+    EXPECT_EQ(bytes, 4294967296ULL);
+    EXPECT_FALSE(parse_memory_limit("max", bytes));
+    // cgroup v1 without a limit
+    EXPECT_FALSE(parse_memory_limit("9223372036854771712", bytes));
+}
+
+TEST(LaunchProfileParseTest, DerivesFromLimits)
+{
+    cgroup_limits limits;
+    limits.cpus = 2.5;
+    limits.memory_bytes = 8ULL << 30;
+
+    launch_profile profile = derive_launch_profile(limits, 64);
+    EXPECT_EQ(profile.cpucount, "3");
+    EXPECT_EQ(profile.threads, "yes");
+    // Several SAS processes share the limit; MEMSIZE is up to the profile
+    EXPECT_TRUE(profile.memsize.empty());
+    EXPECT_TRUE(profile.sortsize.empty());
+
+    // Affinity is tighter than the quota
+    profile = derive_launch_profile(cgroup_limits{4.0, 0}, 1);
+    EXPECT_EQ(profile.cpucount, "1");
+    EXPECT_EQ(profile.threads, "no");
+}
+
+TEST(LaunchProfileParseTest, BuildsOptions)
+{
+    launch_profile profile;
+    profile.memsize = "4G";
+    profile.cpucount = "2";
+    profile.threads = "no";
+    profile.work = "/scratch/work";
+    profile.options = {"-fullstimer"};
+
+    std::vector<std::string> expected = {"-memsize", "4G", "-cpucount", "2", "-work", "/scratch/work",
+                                         "-nothreads", "-fullstimer"};
+    EXPECT_EQ(launch_options(profile), expected);
+    EXPECT_TRUE(launch_options(launch_profile()).empty());
+}
+
+TEST(LaunchProfileParseTest, ExplicitValuesWinOverDerived)
+{
+    launch_profile profile;
+    profile.memsize = "2G";
+    launch_profile derived = derive_launch_profile(cgroup_limits{2.0, 8ULL << 30}, 8);
+
+    profile.threads = "no";
+    fill_launch_profile(profile, derived);
+    EXPECT_EQ(profile.memsize, "2G");
+    EXPECT_EQ(profile.threads, "no");
+    EXPECT_EQ(profile.cpucount, "2");
+}
+
+TEST_F(LaunchProfileTest, ReadsCgroupV2)
+{
+    write("proc_cgroup", "0::/kubepods/pod1/sas\n");
+    write("fs/kubepods/cpu.max", "400000 100000\n");
+    write("fs/kubepods/pod1/cpu.max", "max 100000\n");
+    write("fs/kubepods/pod1/sas/cpu.max", "800000 100000\n");
+    write("fs/kubepods/pod1/memory.max", "2147483648\n");
+    write("fs/kubepods/pod1/sas/memory.max", "max\n");
+
+    // The tightest limit along the path counts
+    cgroup_limits limits = read_cgroup_limits(root + "/proc_cgroup", root + "/fs");
+    EXPECT_DOUBLE_EQ(limits.cpus, 4.0);
+    EXPECT_EQ(limits.memory_bytes, 2147483648ULL);
+}
+
+TEST_F(LaunchProfileTest, ReadsCgroupV1)
+{
+    write("proc_cgroup", "12:memory:/docker/abc\n"
+                         "4:cpu,cpuacct:/docker/abc\n"
+                         "1:name=systemd:/docker/abc\n");
+    write("fs/cpu,cpuacct/cpu.cfs_quota_us", "150000\n");
+    write("fs/cpu,cpuacct/cpu.cfs_period_us", "100000\n");
+    write("fs/memory/memory.limit_in_bytes", "1073741824\n");
+
+    // The container sees its own cgroup at the mount point, not /docker/abc
+    cgroup_limits limits = read_cgroup_limits(root + "/proc_cgroup", root + "/fs");
+    EXPECT_DOUBLE_EQ(limits.cpus, 1.5);
+    EXPECT_EQ(limits.memory_bytes, 1073741824ULL);
+
+    cgroup_limits none = read_cgroup_limits(root + "/missing", root + "/fs");
+    EXPECT_EQ(none.cpus, 0.0);
+    EXPECT_EQ(none.memory_bytes, 0u);
+}
+
+TEST_F(LaunchProfileTest, LoadsProfileFile)
+{
+    write("profile.json", R"({"auto": false, "memsize": "16G", "cpucount": 8,
+                              "options": ["-fullstimer", "-msglevel", "i"]})");
+    launch_profile profile = load_launch_profile(root + "/profile.json");
+    EXPECT_FALSE(profile.auto_tune);
+    EXPECT_EQ(profile.memsize, "16G");
+    EXPECT_EQ(profile.cpucount, "8");
+    ASSERT_EQ(profile.options.size(), 3u);
+
+    // A missing file is the default profile
+    EXPECT_TRUE(load_launch_profile(root + "/missing.json").auto_tune);
+
+    write("typo.json", R"({"memsise": "16G"})");
+    EXPECT_THROW(load_launch_profile(root + "/typo.json"), std::runtime_error);
+    write("threads.json", R"({"threads": "maybe"})");
+    EXPECT_THROW(load_launch_profile(root + "/threads.json"), std::runtime_error);
+    write("broken.json", "{");
+    EXPECT_THROW(load_launch_profile(root + "/broken.json"), std::runtime_error);
+}
+
+TEST_F(LaunchProfileTest, EnvironmentOverridesFile)
+{
+    write("profile.json", R"({"memsize": "16G", "sortsize": "4G"})");
+    setenv("XEUS_SAS_LAUNCH_PROFILE", (root + "/profile.json").c_str(), 1);
+    setenv("XEUS_SAS_MEMSIZE", "8G", 1);
+    setenv("XEUS_SAS_OPTIONS", "-fullstimer  -nonotes", 1);
+    setenv("XEUS_SAS_AUTO_TUNE", "0", 1);
+    setenv("XEUS_SAS_THREADS", "on", 1);
+
+    launch_profile profile = resolve_launch_profile();
+    EXPECT_EQ(profile.memsize, "8G");
+    EXPECT_EQ(profile.sortsize, "4G");
+    EXPECT_TRUE(profile.cpucount.empty());
+    EXPECT_TRUE(profile.threads.empty());
+    std::vector<std::string> extra = {"-fullstimer", "-nonotes"};
+    EXPECT_EQ(profile.options, extra);
+
+    for (const char* name : {"XEUS_SAS_LAUNCH_PROFILE", "XEUS_SAS_MEMSIZE", "XEUS_SAS_OPTIONS", "XEUS_SAS_AUTO_TUNE",
+                             "XEUS_SAS_THREADS"})
+    {
+        unsetenv(name);
+    }
+}
@@ -67,6 +67,15 @@ TEST(ParserTest, GenerateUniqueMarkers)
     EXPECT_GT(marker1.length(), 0);
 }
 
+TEST(ParserTest, DetectsOdsStatements)
+{
+    EXPECT_TRUE(touches_ods("ods select none;\nproc print; run;"));
+    EXPECT_TRUE(touches_ods("proc means; run; ODS\tGRAPHICS OFF;"));
+    EXPECT_FALSE(touches_ods("proc print data=sashelp.class; run;"));
+    EXPECT_FALSE(touches_ods("data pods; set goods ; run;"));
+    EXPECT_FALSE(touches_ods("%let x = ods;"));
+}
+
 TEST(ParserTest, ShouldShowListing)
 {
     execution_result result;
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/process_watchdog.hpp"
+
+#include <stdexcept>
+
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace xeus_sas;
+using namespace std::chrono;
+
+TEST(ProcessWatchdogTest, ParsesDurations)
+{
+    EXPECT_EQ(parse_duration("90"), seconds(90));
+    EXPECT_EQ(parse_duration("90s"), seconds(90));
+    EXPECT_EQ(parse_duration("15m"), minutes(15));
+    EXPECT_EQ(parse_duration("2H"), hours(2));
+    EXPECT_THROW(parse_duration(""), std::invalid_argument);
+    EXPECT_THROW(parse_duration("m"), std::invalid_argument);
+    EXPECT_THROW(parse_duration("10d"), std::invalid_argument);
+    EXPECT_THROW(parse_duration("10ms"), std::invalid_argument);
+}
+
+TEST(ProcessWatchdogTest, ParsesProcStat)
+{
+    // Command names may contain spaces and parentheses
+    std::string stat = "4242 (sas (worker) 1) S 1 4242 4242 0 -1 4194560 5000 0 0 0 "
+                       "1234 567 0 0 20 0 8 0 100 0 0";
+    unsigned long long ticks = 0;
+
+    ASSERT_TRUE(parse_proc_stat_cpu(stat, ticks));
+    EXPECT_EQ(ticks, 1234u + 567u);
+}
+
+TEST(ProcessWatchdogTest, ParsesProcStatTimes)
+{
+    std::string stat = "4242 (sas) R 1 4242 4242 0 -1 4194560 5000 0 0 0 "
+                       "1234 567 0 0 20 0 8 0 100 0 0";
+    unsigned long long user_ticks = 0;
+    unsigned long long system_ticks = 0;
+
+    ASSERT_TRUE(parse_proc_stat_times(stat, user_ticks, system_ticks));
+    EXPECT_EQ(user_ticks, 1234u);
+    EXPECT_EQ(system_ticks, 567u);
+}
+
+TEST(ProcessWatchdogTest, RejectsTruncatedProcStat)
+{
+    unsigned long long ticks = 0;
+    EXPECT_FALSE(parse_proc_stat_cpu("4242 (sas) S 1 4242", ticks));
+    EXPECT_FALSE(parse_proc_stat_cpu("garbage", ticks));
+}
+
+TEST(ProcessWatchdogTest, ParsesProcStatActivity)
+{
+    std::string stat = "4242 (sas) D 1 4242 4242 0 -1 4194560 5000 0 0 0 "
+                       "1234 567 80 9 20 0 8 0 100 0 0";
+    char state = 0;
+    unsigned long long ticks = 0;
+
+    // Time of reaped children (X commands) counts as well
+    ASSERT_TRUE(parse_proc_stat_activity(stat, state, ticks));
+    EXPECT_EQ(state, 'D');
+    EXPECT_EQ(ticks, 1234u + 567u + 80u + 9u);
+    EXPECT_FALSE(parse_proc_stat_activity("4242 (sas) S 1 4242", state, ticks));
+}
+
+TEST(ProcessWatchdogTest, ReadsActivityOfDescendants)
+{
+#ifdef __linux__
+    // A busy grandchild is progress of the process that started it
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        setpgid(0, 0);
+        execl("/bin/sh", "sh", "-c", "sh -c 'while :; do :; done' & wait", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    setpgid(child, child);
+
+    process_activity first;
+    ASSERT_TRUE(read_process_activity(child, first));
+    usleep(300 * 1000);
+    process_activity second;
+    ASSERT_TRUE(read_process_activity(child, second));
+    EXPECT_GT(second.cpu_ticks, first.cpu_ticks);
+
+    kill(-child, SIGKILL);
+    waitpid(child, nullptr, 0);
+#endif
+    process_activity unused;
+    EXPECT_FALSE(read_process_activity(-1, unused));
+}
+
+TEST(ProcessWatchdogTest, ReadsOwnCpuTime)
+{
+#ifdef __linux__
+    unsigned long long ticks = 0;
+    EXPECT_TRUE(read_process_cpu_ticks(getpid(), ticks));
+#endif
+    unsigned long long unused = 0;
+    EXPECT_FALSE(read_process_cpu_ticks(-1, unused));
+}
+
+TEST(ProcessWatchdogTest, HangWithoutOutput)
+{
+    execution_limits limits;
+    limits.hang_timeout = seconds(30);
+    auto start = steady_clock::now();
+    execution_watchdog watchdog(-1, limits, start);
+
+    EXPECT_EQ(watchdog.check(start + seconds(29)), watchdog_verdict::running);
+    EXPECT_EQ(watchdog.check(start + seconds(30)), watchdog_verdict::hung);
+}
+
+TEST(ProcessWatchdogTest, OutputResetsHangTimer)
+{
+    execution_limits limits;
+    limits.hang_timeout = seconds(30);
+    auto start = steady_clock::now();
+    execution_watchdog watchdog(-1, limits, start);
+
+    watchdog.note_output(start + seconds(20));
+    EXPECT_EQ(watchdog.check(start + seconds(45)), watchdog_verdict::running);
+    EXPECT_EQ(watchdog.next_check(start + seconds(45)), seconds(5));
+    EXPECT_EQ(watchdog.check(start + seconds(50)), watchdog_verdict::hung);
+}
+
+TEST(ProcessWatchdogTest, SoftDeadlineReportedOnce)
+{
+    execution_limits limits;
+    limits.soft_deadline = minutes(10);
+    auto start = steady_clock::now();
+    execution_watchdog watchdog(-1, limits, start);
+
+    EXPECT_EQ(watchdog.check(start + minutes(9)), watchdog_verdict::running);
+    EXPECT_EQ(watchdog.check(start + minutes(10)), watchdog_verdict::soft_deadline);
+    EXPECT_EQ(watchdog.check(start + minutes(11)), watchdog_verdict::running);
+}
+
+TEST(ProcessWatchdogTest, HardDeadlineDespiteOutput)
+{
+    execution_limits limits;
+    limits.hard_deadline = minutes(5);
+    limits.hang_timeout = minutes(1);
+    auto start = steady_clock::now();
+    execution_watchdog watchdog(-1, limits, start);
+
+    watchdog.note_output(start + seconds(299));
+    EXPECT_EQ(watchdog.check(start + minutes(5)), watchdog_verdict::hard_deadline);
+}
+
+TEST(ProcessWatchdogTest, MergeKeepsUnsetDefaults)
+{
+    execution_limits session;
+    session.hang_timeout = seconds(120);
+    session.hard_deadline = hours(1);
+
+    execution_limits cell;
+    cell.hard_deadline = hours(4);
+
+    auto merged = session.merged(cell);
+    EXPECT_EQ(merged.hang_timeout, seconds(120));
+    EXPECT_EQ(merged.hard_deadline, hours(4));
+    EXPECT_EQ(merged.soft_deadline.count(), 0);
+}
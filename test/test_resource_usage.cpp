@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/resource_usage.hpp"
+
+#include <string>
+
+#include <unistd.h>
+
+using namespace xeus_sas;
+
+TEST(ResourceUsageTest, ParsesProcStatus)
+{
+    std::string status = "Name:\tsas\n"
+                         "VmPeak:\t 2048000 kB\n"
+                         "VmHWM:\t  812345 kB\n"
+                         "VmRSS:\t  400000 kB\n"
+                         "voluntary_ctxt_switches:\t120\n"
+                         "nonvoluntary_ctxt_switches:\t7\n";
+    resource_sample sample;
+
+    ASSERT_TRUE(parse_proc_status(status, sample));
+    EXPECT_EQ(sample.peak_rss_kb, 812345u);
+    EXPECT_EQ(sample.voluntary_switches, 120u);
+    EXPECT_EQ(sample.involuntary_switches, 7u);
+
+    resource_sample empty;
+    EXPECT_FALSE(parse_proc_status("Name:\tsas\n", empty));
+}
+
+TEST(ResourceUsageTest, ParsesProcIo)
+{
+    std::string io = "rchar: 5000\n"
+                     "wchar: 3000\n"
+                     "syscr: 10\n"
+                     "syscw: 5\n"
+                     "read_bytes: 4096\n"
+                     "write_bytes: 8192\n"
+                     "cancelled_write_bytes: 0\n";
+    resource_sample sample;
+
+    ASSERT_TRUE(parse_proc_io(io, sample));
+    EXPECT_TRUE(sample.has_io);
+    EXPECT_EQ(sample.read_chars, 5000u);
+    EXPECT_EQ(sample.write_chars, 3000u);
+    EXPECT_EQ(sample.read_bytes, 4096u);
+    // "cancelled_write_bytes" must not be taken for "write_bytes"
+    EXPECT_EQ(sample.write_bytes, 8192u);
+
+    resource_sample partial;
+    EXPECT_FALSE(parse_proc_io("rchar: 5000\n", partial));
+    EXPECT_FALSE(partial.has_io);
+}
+
+TEST(ResourceUsageTest, UsageIsDifferenceOfSamples)
+{
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    resource_sample start;
+    start.valid = true;
+    start.user_ticks = 100;
+    start.system_ticks = 50;
+    start.voluntary_switches = 10;
+    start.has_io = true;
+    start.read_bytes = 1000;
+
+    resource_sample end = start;
+    end.user_ticks += 2 * ticks_per_second;
+    end.system_ticks += ticks_per_second;
+    end.peak_rss_kb = 2048;
+    end.voluntary_switches = 15;
+    end.read_bytes = 5000;
+
+    resource_usage usage = usage_between(start, end, true);
+    ASSERT_TRUE(usage.available);
+    EXPECT_DOUBLE_EQ(usage.cpu_user_s, 2.0);
+    EXPECT_DOUBLE_EQ(usage.cpu_system_s, 1.0);
+    EXPECT_EQ(usage.peak_rss_kb, 2048u);
+    EXPECT_TRUE(usage.peak_rss_per_cell);
+    EXPECT_EQ(usage.voluntary_switches, 5u);
+    EXPECT_TRUE(usage.has_io);
+    EXPECT_EQ(usage.read_bytes, 4000u);
+
+    // A missing sample means no numbers rather than wrong ones
+    EXPECT_FALSE(usage_between(start, resource_sample(), true).available);
+}
+
+TEST(ResourceUsageTest, FormatsSummary)
+{
+    resource_usage usage;
+    EXPECT_EQ(format_usage(usage, 1500.0), "SAS: 1.5 s wall, resource usage unavailable");
+
+    usage.available = true;
+    usage.cpu_user_s = 3.9;
+    usage.cpu_system_s = 0.3;
+    usage.peak_rss_kb = 812 * 1024;
+    usage.has_io = true;
+    usage.read_bytes = 2048;
+    usage.voluntary_switches = 4;
+    usage.involuntary_switches = 1;
+
+    std::string line = format_usage(usage, 4200.0);
+    EXPECT_EQ(line, "SAS: 4.2 s wall, 4.2 s CPU (3.9 user, 0.3 sys), peak RSS 812.0 MB (session), "
+                    "read 2.0 KB, written 0 B, 4/1 context switches");
+}
+
+TEST(ResourceUsageTest, SamplesOwnProcess)
+{
+#ifdef __linux__
+    resource_sample sample = sample_process(getpid());
+    EXPECT_TRUE(sample.valid);
+    EXPECT_GT(sample.peak_rss_kb, 0u);
+#endif
+    EXPECT_FALSE(sample_process(-1).valid);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/sas_broker.hpp"
+#include "xeus-sas/sas_process.hpp"
+#include "temp_directory.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <csignal>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace xeus_sas;
+
+namespace
+{
+    // Stands in for SAS: answers the readiness probe and ends on ENDSAS
+    const char* fake_sas_script =
+        "#!/bin/sh\n"
+        "while read line; do\n"
+        "  case \"$line\" in\n"
+        "    *READY*) echo XEUS_SAS_READY >&2 ;;\n"
+        "    endsas*) exit 0 ;;\n"
+        "  esac\n"
+        "done\n";
+
+    class SasBrokerTest : public TempDirectoryTest
+    {
+    protected:
+        SasBrokerTest()
+            : TempDirectoryTest("xeus_sas_broker_")
+        {
+        }
+
+        void SetUp() override
+        {
+            signal(SIGPIPE, SIG_IGN);
+            ASSERT_NO_FATAL_FAILURE(TempDirectoryTest::SetUp());
+            sas = root + "/sas";
+            socket_path = root + "/broker.sock";
+            std::ofstream(sas) << fake_sas_script;
+            chmod(sas.c_str(), 0700);
+        }
+
+        std::string sas;
+        std::string socket_path;
+    };
+}
+
+TEST(LeaseLedgerTest, EnforcesProcessLimit)
+{
+    broker_limits limits;
+    limits.max_processes = 2;
+    lease_ledger ledger(limits);
+    std::string refusal;
+
+    EXPECT_TRUE(ledger.acquire(refusal));
+    EXPECT_TRUE(ledger.acquire(refusal));
+    EXPECT_FALSE(ledger.acquire(refusal));
+    EXPECT_NE(refusal.find("process limit"), std::string::npos);
+
+    ledger.release();
+    EXPECT_EQ(ledger.leased(), 1u);
+    EXPECT_TRUE(ledger.acquire(refusal));
+}
+
+TEST(LeaseLedgerTest, PoolTargetStaysWithinNodeLimit)
+{
+    broker_limits limits;
+    limits.pool_size = 2;
+    limits.max_processes = 4;
+    lease_ledger ledger(limits);
+    std::string refusal;
+
+    EXPECT_EQ(ledger.pool_target(0), 2u);
+    ledger.acquire(refusal);
+    ledger.acquire(refusal);
+    ledger.acquire(refusal);
+    EXPECT_EQ(ledger.pool_target(0), 1u);
+
+    // A lease waiting for its process holds none yet
+    EXPECT_EQ(ledger.pool_target(1), 2u);
+}
+
+TEST(BrokerMessageTest, CarriesDescriptors)
+{
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+    int pipe_fds[2];
+    ASSERT_EQ(pipe(pipe_fds), 0);
+
+    ASSERT_TRUE(send_message(sockets[0], "OK 42", {pipe_fds[1]}));
+    ASSERT_TRUE(send_message(sockets[0], "EXIT 0"));
+
+    std::string line;
+    std::vector<int> fds;
+    ASSERT_TRUE(receive_message(sockets[1], line, fds));
+    EXPECT_EQ(line, "OK 42");
+    ASSERT_EQ(fds.size(), 1u);
+    EXPECT_NE(fcntl(fds[0], F_GETFD) & FD_CLOEXEC, 0);
+
+    // The received descriptor is the pipe's write end
+    ASSERT_EQ(write(fds[0], "x", 1), 1);
+    char c = 0;
+    ASSERT_EQ(read(pipe_fds[0], &c, 1), 1);
+    EXPECT_EQ(c, 'x');
+
+    // The second message stayed in the socket
+    std::vector<int> none;
+    ASSERT_TRUE(receive_message(sockets[1], line, none));
+    EXPECT_EQ(line, "EXIT 0");
+    EXPECT_TRUE(none.empty());
+
+    close(sockets[0]);
+    EXPECT_FALSE(receive_message(sockets[1], line, none));
+    for (int fd : {sockets[1], pipe_fds[0], pipe_fds[1], fds[0]})
+    {
+        close(fd);
+    }
+}
+
+TEST_F(SasBrokerTest, LeasesWarmProcessAndEnforcesProcessLimit)
+{
+    broker_limits limits;
+    limits.pool_size = 1;
+    limits.max_processes = 1;
+    auto broker = std::make_unique<sas_broker>(sas, socket_path, limits);
+    std::thread server([&broker]() { broker->run(); });
+
+    auto process = sas_process::lease(socket_path);
+    EXPECT_GT(process->pid(), 0);
+    EXPECT_NO_THROW(process->wait_until_ready(std::chrono::seconds(10)));
+    EXPECT_FALSE(process->has_exited());
+
+    try
+    {
+        sas_process::lease(socket_path);
+        FAIL() << "lease beyond the process limit was granted";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("process limit"), std::string::npos);
+    }
+
+    // ENDSAS ends the fake; the broker reports the exit over the lease
+    process->terminate(std::chrono::seconds(5));
+    EXPECT_TRUE(process->has_exited());
+    EXPECT_EQ(process->exit_description(), "exited with status 0");
+
+    broker->stop();
+    server.join();
+    broker.reset();
+}
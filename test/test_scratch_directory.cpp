@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/scratch_directory.hpp"
+#include "xeus-sas/work_checkpoint.hpp"
+#include "temp_directory.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace xeus_sas;
+
+namespace
+{
+    bool exists(const std::string& path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0;
+    }
+
+    class ScratchDirectoryTest : public TempDirectoryTest
+    {
+    protected:
+        ScratchDirectoryTest()
+            : TempDirectoryTest("xeus_sas_scratch_test_")
+        {
+        }
+    };
+}
+
+TEST_F(ScratchDirectoryTest, CreatesPrivateDirectoryAndRemovesIt)
+{
+    std::string path;
+    {
+        scratch_directory scratch(root);
+        path = scratch.path();
+        EXPECT_EQ(path.find(root + "/xeus-sas-" + std::to_string(getpid()) + "-"), 0u);
+        EXPECT_TRUE(exists(scratch.work_dir()));
+
+        struct stat info;
+        ASSERT_EQ(stat(path.c_str(), &info), 0);
+        EXPECT_EQ(info.st_mode & 0777, 0700u);
+
+        std::ofstream(scratch.file("batch.sas")) << "run;\n";
+        EXPECT_TRUE(exists(path + "/batch.sas"));
+
+        // Removed on shutdown, recreated when SAS starts again
+        scratch.remove();
+        EXPECT_FALSE(exists(path));
+        scratch.ensure();
+        EXPECT_TRUE(exists(scratch.work_dir()));
+    }
+    EXPECT_FALSE(exists(path));
+}
+
+TEST_F(ScratchDirectoryTest, SweepsDirectoriesNobodyHolds)
+{
+    // The lock of a kernel that died is released with its descriptors;
+    // a live kernel's PID may not even be visible from here
+    std::string dead = root + "/xeus-sas-12345-abc123";
+    std::string alive = root + "/xeus-sas-12345-def456";
+    std::string unlocked = root + "/xeus-sas-12345-ghi789";
+    std::string unrelated = root + "/xeus-sas-notapid";
+    for (const auto& path : {dead, alive, unlocked, unrelated})
+    {
+        make_directories(path + "/work");
+    }
+    std::ofstream(dead + "/" + directory_lock::file_name);
+    directory_lock held;
+    held.acquire(alive);
+    scratch_directory own(root);
+
+    EXPECT_EQ(sweep_orphaned_directories(root, scratch_directory::name_prefix), 1u);
+    EXPECT_FALSE(exists(dead));
+    EXPECT_TRUE(exists(alive));
+    EXPECT_TRUE(exists(own.work_dir()));
+    // Without a lock file the owner may still be setting it up
+    EXPECT_TRUE(exists(unlocked));
+    EXPECT_TRUE(exists(unrelated));
+
+    held.release();
+    EXPECT_EQ(sweep_orphaned_directories(root, scratch_directory::name_prefix), 1u);
+    EXPECT_FALSE(exists(alive));
+
+    EXPECT_EQ(sweep_orphaned_directories(root + "/missing", scratch_directory::name_prefix), 0u);
+}
+
+TEST(ScratchDirectoryBaseTest, FollowsEnvironment)
+{
+    setenv("XEUS_SAS_SCRATCH_DIR", "tmpfs", 1);
+    EXPECT_EQ(scratch_directory::default_base(), "/dev/shm");
+    setenv("XEUS_SAS_SCRATCH_DIR", "/nvme/scratch", 1);
+    EXPECT_EQ(scratch_directory::default_base(), "/nvme/scratch");
+    unsetenv("XEUS_SAS_SCRATCH_DIR");
+}
@@ -1,5 +1,13 @@
 #include <gtest/gtest.h>
 #include "xeus-sas/sas_session.hpp"
+#include "xeus-sas/work_checkpoint.hpp"
+#include "temp_directory.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <sys/stat.h>
 
 using namespace xeus_sas;
 
@@ -12,6 +20,9 @@ TEST(SessionTest, DISABLED_CreateSession)
     // This test requires SAS to be installed
     EXPECT_NO_THROW({
         sas_session session;
+        EXPECT_FALSE(session.is_ready());
+        session.start();
+        session.execute("");
         EXPECT_TRUE(session.is_ready());
     });
 }
@@ -57,6 +68,43 @@ TEST(SessionTest, DISABLED_MacroVariable)
     EXPECT_EQ(value, "test_value");
 }
 
+TEST(SessionTest, DISABLED_SavesLibrefsFromDictionary)
+{
+    // DICTIONARY.LIBNAMES on Unix has one row per SYSNAME for every level;
+    // settings.sas must still name each path once, with the engine
+    std::string root = make_temp_directory("xeus_sas_settings_");
+    ASSERT_FALSE(root.empty());
+    for (const char* directory : {"/one", "/two", "/ckpt"})
+    {
+        ASSERT_EQ(mkdir((root + directory).c_str(), 0700), 0);
+    }
+
+    sas_session session;
+    auto result = session.execute("libname single v9 '" + root + "/one';\n"
+                                  "libname both ('" + root + "/one' '" + root + "/two');\n" +
+                                  save_settings_code(root + "/ckpt"));
+    EXPECT_FALSE(result.is_error);
+
+    std::ifstream in(root + "/ckpt/settings.sas");
+    std::stringstream settings;
+    settings << in.rdbuf();
+    auto count = [&settings](const std::string& text)
+    {
+        size_t found = 0;
+        for (size_t pos = settings.str().find(text); pos != std::string::npos;
+             pos = settings.str().find(text, pos + 1))
+        {
+            ++found;
+        }
+        return found;
+    };
+    EXPECT_EQ(count("'" + root + "/one'"), 2u);
+    EXPECT_EQ(count("'" + root + "/two'"), 1u);
+    EXPECT_EQ(count("SINGLE V9"), 1u);
+
+    remove_tree(root);
+}
+
 // Mock test that doesn't require SAS
 TEST(SessionTest, SessionStructure)
 {
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/session_manager.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace xeus_sas;
+
+TEST(SessionMagicTest, NoMagicUsesDefaultSession)
+{
+    std::string code = "data a; x = 1; run;";
+    auto target = parse_cell_magics(code);
+
+    EXPECT_EQ(target.session, default_session_name);
+    EXPECT_EQ(target.code, code);
+}
+
+TEST(SessionMagicTest, MagicSelectsSessionAndIsStripped)
+{
+    auto target = parse_cell_magics("%%session etl\ndata a; x = 1; run;\n");
+
+    EXPECT_EQ(target.session, "etl");
+    EXPECT_EQ(target.code, "data a; x = 1; run;\n");
+}
+
+TEST(SessionMagicTest, LeadingBlankLinesAndTrailingSpaceAreAllowed)
+{
+    auto target = parse_cell_magics("\n  %%session model-fit  \r\nproc reg; run;");
+
+    EXPECT_EQ(target.session, "model-fit");
+    EXPECT_EQ(target.code, "proc reg; run;");
+}
+
+TEST(SessionMagicTest, MagicWithoutCode)
+{
+    auto target = parse_cell_magics("%%session etl");
+
+    EXPECT_EQ(target.session, "etl");
+    EXPECT_EQ(target.code, "");
+}
+
+TEST(SessionMagicTest, OtherMagicIsLeftAlone)
+{
+    std::string code = "%%sessions\ndata a; run;";
+    auto target = parse_cell_magics(code);
+
+    EXPECT_EQ(target.session, default_session_name);
+    EXPECT_EQ(target.code, code);
+}
+
+TEST(SessionMagicTest, MalformedMagicThrows)
+{
+    EXPECT_THROW(parse_cell_magics("%%session\ndata a; run;"), std::invalid_argument);
+    EXPECT_THROW(parse_cell_magics("%%session two words\n"), std::invalid_argument);
+}
+
+TEST(SessionMagicTest, LimitsMagicSetsPerCellLimits)
+{
+    auto target = parse_cell_magics("%%limits soft=10m hard=2h\n%%session etl\ndata a; run;");
+
+    EXPECT_EQ(target.session, "etl");
+    EXPECT_EQ(target.limits.soft_deadline, std::chrono::minutes(10));
+    EXPECT_EQ(target.limits.hard_deadline, std::chrono::hours(2));
+    EXPECT_EQ(target.limits.hang_timeout.count(), 0);
+    EXPECT_EQ(target.code, "data a; run;");
+}
+
+TEST(SessionMagicTest, MalformedLimitsThrow)
+{
+    EXPECT_THROW(parse_cell_magics("%%limits\n"), std::invalid_argument);
+    EXPECT_THROW(parse_cell_magics("%%limits soft=ten\n"), std::invalid_argument);
+    EXPECT_THROW(parse_cell_magics("%%limits wall=10\n"), std::invalid_argument);
+}
+
+TEST(SessionMagicTest, CheckpointMagic)
+{
+    auto target = parse_cell_magics("%%checkpoint\ndata a; run;");
+
+    EXPECT_TRUE(target.checkpoint);
+    EXPECT_EQ(target.code, "data a; run;");
+    EXPECT_FALSE(parse_cell_magics("data a; run;").checkpoint);
+    EXPECT_THROW(parse_cell_magics("%%checkpoint now\n"), std::invalid_argument);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/stream_scanner.hpp"
+
+using namespace xeus_sas;
+
+TEST(StreamScannerTest, FindsAllPatterns)
+{
+    stream_scanner scanner({"<div", "</div>", "END"});
+    std::string text = "<div>x</div>END";
+    std::vector<scan_match> matches;
+
+    scanner.feed(text.data(), text.size(), matches);
+
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].pattern, 0u);
+    EXPECT_EQ(matches[0].offset, 0u);
+    EXPECT_EQ(matches[1].pattern, 1u);
+    EXPECT_EQ(matches[1].offset, 6u);
+    EXPECT_EQ(matches[2].pattern, 2u);
+    EXPECT_EQ(matches[2].offset, 12u);
+}
+
+TEST(StreamScannerTest, MatchSplitAcrossChunks)
+{
+    stream_scanner scanner({"XEUS_SAS_END_1"});
+    std::string text = "NOTE: done\nXEUS_SAS_END_1\n";
+    std::vector<scan_match> matches;
+
+    // Feed one byte at a time: the worst possible pipe split
+    for (char c : text)
+    {
+        scanner.feed(&c, 1, matches);
+    }
+
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].offset, 11u);
+    EXPECT_EQ(scanner.bytes_scanned(), text.size());
+}
+
+TEST(StreamScannerTest, OverlappingPatterns)
+{
+    // "<table" must not hide "</table>" and suffix matches must be reported
+    stream_scanner scanner({"<table", "</table>", "able"});
+    std::string text = "<table></table>";
+    std::vector<scan_match> matches;
+
+    scanner.feed(text.data(), text.size(), matches);
+
+    size_t open = 0, close = 0, suffix = 0;
+    for (const auto& m : matches)
+    {
+        if (m.pattern == 0) open++;
+        if (m.pattern == 1) close++;
+        if (m.pattern == 2) suffix++;
+    }
+    EXPECT_EQ(open, 1u);
+    EXPECT_EQ(close, 1u);
+    EXPECT_EQ(suffix, 2u);
+}
+
+TEST(StreamScannerTest, RepeatedPrefixDoesNotLoseMatch)
+{
+    stream_scanner scanner({"aab"});
+    std::string text = "aaab";
+    std::vector<scan_match> matches;
+
+    scanner.feed(text.data(), text.size(), matches);
+
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].offset, 1u);
+}
+
+TEST(StreamScannerTest, ResetForgetsPartialMatch)
+{
+    stream_scanner scanner({"END"});
+    std::vector<scan_match> matches;
+
+    scanner.feed("EN", 2, matches);
+    scanner.reset();
+    scanner.feed("D", 1, matches);
+
+    EXPECT_TRUE(matches.empty());
+    EXPECT_EQ(scanner.bytes_scanned(), 1u);
+}
+
+TEST(StreamScannerTest, RejectsEmptyPattern)
+{
+    EXPECT_THROW(stream_scanner({""}), std::invalid_argument);
+}
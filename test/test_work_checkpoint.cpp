@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "xeus-sas/work_checkpoint.hpp"
+#include "temp_directory.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace xeus_sas;
+
+namespace
+{
+    class WorkCheckpointTest : public TempDirectoryTest
+    {
+    protected:
+        WorkCheckpointTest()
+            : TempDirectoryTest("xeus_sas_test_")
+        {
+        }
+
+        void SetUp() override
+        {
+            ASSERT_NO_FATAL_FAILURE(TempDirectoryTest::SetUp());
+            work = root + "/work";
+            snapshot = root + "/checkpoint/work";
+            make_directories(work);
+        }
+
+        void write_file(const std::string& path, const std::string& content)
+        {
+            std::ofstream(path) << content;
+        }
+
+        std::string read_file(const std::string& path)
+        {
+            std::ifstream in(path);
+            std::stringstream content;
+            content << in.rdbuf();
+            return content.str();
+        }
+
+        ino_t inode(const std::string& path)
+        {
+            struct stat info;
+            return stat(path.c_str(), &info) == 0 ? info.st_ino : 0;
+        }
+
+        std::string work;
+        std::string snapshot;
+    };
+}
+
+TEST(WorkCheckpointMembersTest, RecognizesLibraryMembers)
+{
+    EXPECT_TRUE(is_library_member("sales.sas7bdat"));
+    EXPECT_TRUE(is_library_member("formats.sas7bcat"));
+    EXPECT_TRUE(is_library_member("v_sales.sas7bvew"));
+    EXPECT_TRUE(is_library_member("sales.sas7bndx"));
+    EXPECT_FALSE(is_library_member("sales.sas7bdat.lck"));
+    EXPECT_FALSE(is_library_member("sales.sas7bdat.partial"));
+    EXPECT_FALSE(is_library_member("SAS_util0001000012AB_host"));
+}
+
+TEST_F(WorkCheckpointTest, CopiesNewMembersAndKeepsUnchangedOnes)
+{
+    write_file(work + "/a.sas7bdat", "first");
+    write_file(work + "/b.sas7bdat", "second");
+    write_file(work + "/a.sas7bdat.lck", "in progress");
+
+    auto stats = sync_work_snapshot(work, snapshot);
+    EXPECT_EQ(stats.cloned + stats.copied, 2u);
+    EXPECT_EQ(read_file(snapshot + "/a.sas7bdat"), "first");
+    EXPECT_NE(inode(snapshot + "/a.sas7bdat"), inode(work + "/a.sas7bdat"));
+    EXPECT_NE(access((snapshot + "/a.sas7bdat.lck").c_str(), F_OK), 0);
+
+    stats = sync_work_snapshot(work, snapshot);
+    EXPECT_EQ(stats.cloned + stats.copied, 0u);
+    EXPECT_EQ(stats.unchanged, 2u);
+}
+
+TEST_F(WorkCheckpointTest, RewrittenMemberIsCopiedAgain)
+{
+    write_file(work + "/a.sas7bdat", "old");
+    sync_work_snapshot(work, snapshot);
+
+    // SAS replaces a data set it rewrites with a new file
+    write_file(work + "/a.sas7bdat.new", "new");
+    ASSERT_EQ(rename((work + "/a.sas7bdat.new").c_str(), (work + "/a.sas7bdat").c_str()), 0);
+
+    auto stats = sync_work_snapshot(work, snapshot);
+    EXPECT_EQ(stats.cloned + stats.copied, 1u);
+    EXPECT_EQ(read_file(snapshot + "/a.sas7bdat"), "new");
+}
+
+TEST_F(WorkCheckpointTest, InPlaceUpdateDoesNotReachTheSnapshot)
+{
+    write_file(work + "/a.sas7bdat", "rows 1-10");
+    write_file(work + "/formats.sas7bcat", "formats");
+    sync_work_snapshot(work, snapshot);
+
+    // PROC APPEND and catalog updates write into the existing file; one
+    // cut short must leave the checkpoint as it was
+    std::ofstream(work + "/a.sas7bdat", std::ios::app) << " + half of rows 11-20";
+    std::ofstream(work + "/formats.sas7bcat", std::ios::in | std::ios::out) << "FORMATS";
+    EXPECT_EQ(read_file(snapshot + "/a.sas7bdat"), "rows 1-10");
+    EXPECT_EQ(read_file(snapshot + "/formats.sas7bcat"), "formats");
+
+    // The next checkpoint picks the update up
+    auto stats = sync_work_snapshot(work, snapshot);
+    EXPECT_GE(stats.cloned + stats.copied, 1u);
+    EXPECT_EQ(read_file(snapshot + "/a.sas7bdat"), "rows 1-10 + half of rows 11-20");
+}
+
+TEST_F(WorkCheckpointTest, HardLinkFromOlderSnapshotIsReplaced)
+{
+    write_file(work + "/a.sas7bdat", "data");
+    make_directories(snapshot);
+    ASSERT_EQ(link((work + "/a.sas7bdat").c_str(), (snapshot + "/a.sas7bdat").c_str()), 0);
+
+    auto stats = sync_work_snapshot(work, snapshot);
+    EXPECT_EQ(stats.cloned + stats.copied, 1u);
+    EXPECT_NE(inode(snapshot + "/a.sas7bdat"), inode(work + "/a.sas7bdat"));
+}
+
+TEST_F(WorkCheckpointTest, DeletedMembersLeaveTheSnapshot)
+{
+    write_file(work + "/a.sas7bdat", "a");
+    write_file(work + "/b.sas7bdat", "b");
+    sync_work_snapshot(work, snapshot);
+
+    unlink((work + "/b.sas7bdat").c_str());
+    auto stats = sync_work_snapshot(work, snapshot);
+    EXPECT_EQ(stats.removed, 1u);
+    EXPECT_NE(access((snapshot + "/b.sas7bdat").c_str(), F_OK), 0);
+}
+
+TEST_F(WorkCheckpointTest, RestoreCopiesIntoNewWork)
+{
+    write_file(work + "/a.sas7bdat", "data");
+    write_file(work + "/sasmacr.sas7bcat", "macros");
+    sync_work_snapshot(work, snapshot);
+
+    std::string new_work = root + "/work2";
+    make_directories(new_work);
+    write_file(new_work + "/sasmacr.sas7bcat", "already open");
+
+    auto stats = restore_work_snapshot(snapshot, new_work);
+    EXPECT_EQ(stats.copied, 1u);
+    EXPECT_EQ(stats.unchanged, 1u);
+    EXPECT_EQ(read_file(new_work + "/a.sas7bdat"), "data");
+    EXPECT_NE(inode(new_work + "/a.sas7bdat"), inode(snapshot + "/a.sas7bdat"));
+    EXPECT_EQ(read_file(new_work + "/sasmacr.sas7bcat"), "already open");
+}
+
+TEST(WorkCheckpointCodeTest, ParsesWorkPathFromLog)
+{
+    std::string log = "%put XEUS_SAS_%str()WORK=%sysfunc(pathname(work));\n"
+                      "XEUS_SAS_WORK=/saswork/SAS_work4A2B0000_host\n"
+                      "NOTE: done\n";
+    EXPECT_EQ(parse_work_path(log), "/saswork/SAS_work4A2B0000_host");
+    EXPECT_EQ(parse_work_path("NOTE: nothing here\n"), "");
+    EXPECT_NE(work_path_probe_code().find("%str()"), std::string::npos);
+}
+
+TEST(WorkCheckpointCodeTest, QuotesCheckpointDirectory)
+{
+    std::string code = save_macros_code("/data/o'brien/ckpt");
+    EXPECT_NE(code.find("libname _xsckpt '/data/o''brien/ckpt';"), std::string::npos);
+    EXPECT_NE(code.find("sashelp.vmacro"), std::string::npos);
+    EXPECT_NE(restore_macros_code("/ckpt").find("call symputx(name, _xs_value, 'G')"), std::string::npos);
+}
+
+TEST(WorkCheckpointCodeTest, SavesAndReloadsSettings)
+{
+    std::string save = save_settings_code("/data/o'brien/ckpt");
+    EXPECT_NE(save.find("proc optsave out=_xsckpt.options;"), std::string::npos);
+    EXPECT_NE(save.find("file '/data/o''brien/ckpt/settings.sas';"), std::string::npos);
+    EXPECT_NE(save.find("file '/data/o''brien/ckpt/settings.sas' mod;"), std::string::npos);
+    EXPECT_NE(save.find("sashelp.vlibnam"), std::string::npos);
+    // One path per library level, not one per SYSNAME row
+    EXPECT_NE(save.find("by libname level notsorted;"), std::string::npos);
+    EXPECT_NE(save.find("if first.level then do;"), std::string::npos);
+    EXPECT_NE(save.find("sashelp.vextfl"), std::string::npos);
+
+    std::string restore = restore_settings_code("/ckpt");
+    EXPECT_NE(restore.find("proc optload data=_xsckpt.options;"), std::string::npos);
+    EXPECT_NE(restore.find("%include '/ckpt/settings.sas';"), std::string::npos);
+}